@@ -11,6 +11,6 @@ int main(int argc, char **argv) {
 	printf("Hi Ther. #1\n");
 	delay_ms(1000);
 	printf("Hi Ther. #2\n");
-	while (1);
+	while (1) delay_ms(1000);
 	return 0;
 }
@@ -6,3 +6,7 @@
 
 // Configure I2C0 clock.
 void clkconfig_i2c0(uint32_t freq_hz, bool enable, bool reset);
+// Configure SHA accelerator clock.
+void clkconfig_sha(bool enable, bool reset);
+// Configure whether the CPU clock keeps running while the CPU waits in WFI.
+void clkconfig_cpu_waiti(bool force_on);
@@ -0,0 +1,40 @@
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sched.h>
+
+// Console output backends.
+typedef enum {
+	// UART0, as wired to the USB-serial bridge on most boards.
+	CONSOLE_UART,
+	// The built-in USB Serial/JTAG controller.
+	CONSOLE_USB_JTAG,
+} console_backend_t;
+
+// Backend used until `console_select` is called; set with -DCONSOLE_DEFAULT.
+#ifndef CONSOLE_DEFAULT
+#define CONSOLE_DEFAULT CONSOLE_UART
+#endif
+
+// Switch the selected console backend to interrupt-driven output. Call after `timer_init`.
+// A backend selected later with `console_select` is switched over when it is selected.
+void console_init();
+// Select the backend console output goes to.
+void console_select(console_backend_t backend);
+// Get the backend console output goes to.
+console_backend_t console_selected();
+// Write `len` bytes to the console. May be called from interrupt handlers.
+void console_write(const void *data, size_t len);
+// Write one byte to the console.
+void console_putc(char c);
+// Number of bytes that can be written to the console without dropping any.
+size_t console_tx_free();
+// Post `task` once the console's transmit buffer is empty, or right away if it already is.
+// Only one task can wait at a time; a later call replaces the earlier one.
+void console_tx_notify(sched_task_t *task);
+// Wait until buffered console output has been sent.
+void console_flush();
+// Drain the console and make all further output synchronous; for use when the system is going down.
+void console_panic();
@@ -0,0 +1,14 @@
+
+#pragma once
+
+#include <stdint.h>
+
+// Maximum number of decimal digits in a 64-bit unsigned value.
+#define DECIMAL_MAX_DIGITS 20
+
+// Convert `val` to decimal ASCII, writing backwards so the last digit is just before `end`.
+// Returns a pointer to the first digit; there is no terminator and at least one digit is written.
+char *decimal_u32(uint32_t val, char *end);
+// Convert `val` to decimal ASCII, writing backwards so the last digit is just before `end`.
+// Returns a pointer to the first digit; `end` must have room for DECIMAL_MAX_DIGITS before it.
+char *decimal_u64(uint64_t val, char *end);
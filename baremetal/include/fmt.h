@@ -0,0 +1,13 @@
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+// Format into `buf` of `size` bytes, truncating if needed, and return the length without the terminating NUL.
+// Supports %d, %i, %u, %x, %X, %s, %c, %p and %%, with the flags '-' and '0', a field width (or '*'),
+// and the length modifiers 'l', 'll' and 'z'.
+size_t fmt_vformat(char *buf, size_t size, const char *fmt, va_list args);
+// Format into `buf` of `size` bytes, truncating if needed, and return the length without the terminating NUL.
+size_t fmt_format(char *buf, size_t size, const char *fmt, ...);
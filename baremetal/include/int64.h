@@ -0,0 +1,38 @@
+
+#pragma once
+
+#include <stdint.h>
+
+// The 64-bit division runtime (__udivdi3 and friends) lives in int64.c.
+// Dividing by a constant through it still costs a long division, so hot paths dividing by
+// one of the constants below should use these multiply-high helpers instead; they are exact for all inputs.
+
+// Upper 64 bits of a 64x64-bit product, from 32-bit multiplies.
+static inline uint64_t int64_mulhi(uint64_t a, uint64_t b) {
+	uint64_t lo_lo = (uint64_t) (uint32_t) a * (uint32_t) b;
+	uint64_t hi_lo = (uint64_t) (uint32_t) (a >> 32) * (uint32_t) b;
+	uint64_t lo_hi = (uint64_t) (uint32_t) a * (uint32_t) (b >> 32);
+	uint64_t hi_hi = (uint64_t) (uint32_t) (a >> 32) * (uint32_t) (b >> 32);
+	uint64_t mid   = (lo_lo >> 32) + (uint32_t) hi_lo + (uint32_t) lo_hi;
+	return hi_hi + (hi_lo >> 32) + (lo_hi >> 32) + (mid >> 32);
+}
+
+// Exact `val / 10`.
+static inline uint64_t int64_udiv10(uint64_t val) {
+	return int64_mulhi(val, 0xCCCCCCCCCCCCCCCD) >> 3;
+}
+
+// Exact `val / 1000`.
+static inline uint64_t int64_udiv1000(uint64_t val) {
+	return int64_mulhi(val >> 1, 0x20C49BA5E353F7CF) >> 6;
+}
+
+// Exact `val / 1000000`.
+static inline uint64_t int64_udiv1000000(uint64_t val) {
+	return int64_mulhi(val, 0x431BDE82D7B634DB) >> 18;
+}
+
+// Exact `val / 100000000`.
+static inline uint64_t int64_udiv100000000(uint64_t val) {
+	return int64_mulhi(val, 0xABCC77118461CEFD) >> 26;
+}
@@ -0,0 +1,91 @@
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <badge_err.h>
+
+// Number of CPU interrupt channels; channel 0 is reserved for exceptions.
+#define ISR_CHANNEL_COUNT		32
+// Number of interrupt matrix sources.
+#define ISR_SOURCE_COUNT		77
+// Highest interrupt priority.
+#define ISR_PRIORITY_MAX		15
+// CPU interrupt channel used by `isr_measure_latency`.
+#define ISR_CHANNEL_SELFTEST	31
+// CPU interrupt channel used by the timer service.
+#define ISR_CHANNEL_TIMER		1
+// CPU interrupt channel used by the UART driver.
+#define ISR_CHANNEL_UART		2
+// CPU interrupt channel used by the USB Serial/JTAG driver.
+#define ISR_CHANNEL_USB_JTAG	3
+
+// Interrupt matrix source: software interrupt 0.
+#define ISR_SRC_FROM_CPU_0		22
+// Interrupt matrix source: UART0.
+#define ISR_SRC_UART0			43
+// Interrupt matrix source: UART1.
+#define ISR_SRC_UART1			44
+// Interrupt matrix source: USB serial / JTAG controller.
+#define ISR_SRC_USB_SERIAL_JTAG	48
+// Interrupt matrix source: I²C controller.
+#define ISR_SRC_I2C_EXT0		50
+// Interrupt matrix source: TIMG0 timer 0.
+#define ISR_SRC_TG0_T0			51
+
+// Interrupt handler; `channel` is the CPU interrupt channel that fired.
+typedef void (*isr_handler_t)(int channel, void *cookie);
+
+// Latency and duration statistics of one interrupt channel, in CPU cycles.
+typedef struct {
+	// Number of times the interrupt was handled.
+	uint32_t count;
+	// Cycles from the last `isr_latency_mark` to trap entry, for the last marked interrupt.
+	uint32_t latency_last;
+	// Largest marked latency seen.
+	uint32_t latency_max;
+	// Longest time spent in the handler.
+	uint32_t duration_max;
+} isr_stats_t;
+
+// Disable interrupts globally.
+// Returns whether they were enabled, to be passed to `isr_global_restore`.
+static inline bool isr_global_disable() {
+	uint32_t mstatus;
+	asm volatile ("csrrci %0, mstatus, 8" : "=r" (mstatus) :: "memory");
+	return mstatus & 8;
+}
+// Re-enable interrupts globally if `enable` is true.
+static inline void isr_global_restore(bool enable) {
+	if (enable) asm volatile ("csrsi mstatus, 8" ::: "memory");
+}
+// Enable interrupts globally.
+static inline void isr_global_enable() {
+	asm volatile ("csrsi mstatus, 8" ::: "memory");
+}
+
+// Initialise the interrupt subsystem: install the trap vector, unroute all sources and enable interrupts globally.
+// Call after `time_init`, which starts the cycle counter used for latency statistics.
+void isr_init();
+// Register `handler` for CPU interrupt `channel`, or unregister it with NULL.
+void isr_set_handler	(badge_err_t *ec, int channel, isr_handler_t handler, void *cookie);
+// Route interrupt matrix `source` to CPU interrupt `channel`, or disconnect it with channel 0.
+void isr_route			(badge_err_t *ec, int source, int channel);
+// Set the priority of CPU interrupt `channel` (1 to ISR_PRIORITY_MAX; 0 never fires).
+void isr_set_priority	(badge_err_t *ec, int channel, int priority);
+// Set whether CPU interrupt `channel` is edge-triggered instead of level-triggered.
+void isr_set_edge		(badge_err_t *ec, int channel, bool edge);
+// Enable or disable CPU interrupt `channel`.
+void isr_enable			(badge_err_t *ec, int channel, bool enable);
+// Set the priority threshold; interrupts with a lower priority are masked.
+void isr_set_threshold	(badge_err_t *ec, int threshold);
+
+// Latency hook: record that an interrupt on `channel` is expected from now on, e.g. right before triggering it.
+// The next trap on `channel` will record the cycles between this call and trap entry.
+void isr_latency_mark	(int channel);
+// Get the statistics of CPU interrupt `channel`.
+void isr_get_stats		(badge_err_t *ec, int channel, isr_stats_t *out);
+// Measure interrupt entry latency in cycles using a software interrupt on ISR_CHANNEL_SELFTEST.
+uint32_t isr_measure_latency();
@@ -15,3 +15,53 @@ typedef enum {
 void logk (log_level_t level, const char *msg);
 // Print a formatted message.
 void logkf(log_level_t level, const char *msg, ...);
+
+
+
+// Binary logging: `logkb` stores a record of the timestamp, level, format string address and raw arguments
+// in a RAM buffer instead of formatting it. The buffer is drained to the console later as COBS frames
+// delimited by zero bytes, and logdecode.py turns them back into text using the ELF file.
+// At most 8 arguments are supported; %s arguments are only readable if they point into the image.
+
+// Magic value in the top byte of a binary log record header.
+#define LOG_BIN_MAGIC 0xB1
+
+// Count the variadic arguments, up to 8.
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+// Header bits for argument `i`: a flag in bits 8-15 if it is 64-bit and its size in words in bits 16-23.
+#define LOG_ARG(i, x) ((uint32_t) (sizeof(x) > 4) << (8 + (i))) + ((uint32_t) (sizeof(x) > 4 ? 2 : 1) << 16)
+#define LOG_ARGS_0()
+#define LOG_ARGS_1(a)                      + LOG_ARG(0, a)
+#define LOG_ARGS_2(a, b)                   LOG_ARGS_1(a) + LOG_ARG(1, b)
+#define LOG_ARGS_3(a, b, c)                LOG_ARGS_2(a, b) + LOG_ARG(2, c)
+#define LOG_ARGS_4(a, b, c, d)             LOG_ARGS_3(a, b, c) + LOG_ARG(3, d)
+#define LOG_ARGS_5(a, b, c, d, e)          LOG_ARGS_4(a, b, c, d) + LOG_ARG(4, e)
+#define LOG_ARGS_6(a, b, c, d, e, f)       LOG_ARGS_5(a, b, c, d, e) + LOG_ARG(5, f)
+#define LOG_ARGS_7(a, b, c, d, e, f, g)    LOG_ARGS_6(a, b, c, d, e, f) + LOG_ARG(6, g)
+#define LOG_ARGS_8(a, b, c, d, e, f, g, h) LOG_ARGS_7(a, b, c, d, e, f, g) + LOG_ARG(7, h)
+#define LOG_ARGS_(n, ...) LOG_ARGS_##n(__VA_ARGS__)
+#define LOG_ARGS(n, ...) LOG_ARGS_(n, ##__VA_ARGS__)
+
+// Record header, computed at compile time: magic, length in words, 64-bit argument flags, argument count and level.
+#define LOG_BIN_HEADER(level, ...) ( \
+	((uint32_t) LOG_BIN_MAGIC << 24) + (3 << 16) + ((uint32_t) LOG_NARGS(__VA_ARGS__) << 4) + (level) \
+	LOG_ARGS(LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__) \
+)
+
+// Log a binary record; takes tens of cycles and no console time.
+#define logkb(level, msg, ...) logkb_write(LOG_BIN_HEADER(level, ##__VA_ARGS__), msg, ##__VA_ARGS__)
+
+// Store a binary log record; use the `logkb` macro instead.
+void logkb_write(uint32_t header, const char *msg, ...);
+// Write all pending binary log records to the console now.
+void logkb_flush();
+// Number of binary log records dropped because the buffer was full.
+uint32_t logkb_dropped();
+
+#ifdef LOG_BINARY
+// Route the text log API to the binary log.
+#define logk(level, msg)  logkb(level, msg)
+#define logkf(level, ...) logkb(level, __VA_ARGS__)
+#endif
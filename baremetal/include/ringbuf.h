@@ -0,0 +1,84 @@
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Byte ring buffer for one producer and one consumer.
+// The indices run freely and are masked on access, so `size` must be a power of two.
+// If the producer and consumer run in different contexts (e.g. task and ISR), the caller provides the locking.
+typedef struct {
+	// Storage of `size` bytes.
+	uint8_t          *buf;
+	// Capacity in bytes, a power of two.
+	uint32_t          size;
+	// Write index.
+	volatile uint32_t head;
+	// Read index.
+	volatile uint32_t tail;
+} ringbuf_t;
+
+// Initialise `rb` to use `size` bytes at `buf`; `size` must be a power of two.
+static inline void ringbuf_init(ringbuf_t *rb, void *buf, uint32_t size) {
+	rb->buf  = buf;
+	rb->size = size;
+	rb->head = 0;
+	rb->tail = 0;
+}
+
+// Number of bytes available to read.
+static inline uint32_t ringbuf_used(const ringbuf_t *rb) {
+	return rb->head - rb->tail;
+}
+
+// Number of bytes available to write.
+static inline uint32_t ringbuf_free(const ringbuf_t *rb) {
+	return rb->size - (rb->head - rb->tail);
+}
+
+// Write up to `len` bytes, returning how many fit.
+static inline size_t ringbuf_write(ringbuf_t *rb, const void *data, size_t len) {
+	uint32_t space = ringbuf_free(rb);
+	if (len > space) len = space;
+	uint32_t off   = rb->head & (rb->size - 1);
+	uint32_t first = rb->size - off;
+	if (first > len) first = len;
+	memcpy(rb->buf + off, data, first);
+	memcpy(rb->buf, (const uint8_t *) data + first, len - first);
+	rb->head += len;
+	return len;
+}
+
+// Copy up to `len` bytes without consuming them, returning how many were copied.
+static inline size_t ringbuf_copy(const ringbuf_t *rb, void *out, size_t len) {
+	uint32_t avail = ringbuf_used(rb);
+	if (len > avail) len = avail;
+	uint32_t off   = rb->tail & (rb->size - 1);
+	uint32_t first = rb->size - off;
+	if (first > len) first = len;
+	memcpy(out, rb->buf + off, first);
+	memcpy((uint8_t *) out + first, rb->buf, len - first);
+	return len;
+}
+
+// Read up to `len` bytes, returning how many were read.
+static inline size_t ringbuf_read(ringbuf_t *rb, void *out, size_t len) {
+	len = ringbuf_copy(rb, out, len);
+	rb->tail += len;
+	return len;
+}
+
+// Get a pointer to the contiguous readable bytes and their count, without consuming them.
+static inline uint32_t ringbuf_peek(const ringbuf_t *rb, const uint8_t **ptr) {
+	uint32_t avail = ringbuf_used(rb);
+	uint32_t off   = rb->tail & (rb->size - 1);
+	uint32_t first = rb->size - off;
+	*ptr = rb->buf + off;
+	return avail < first ? avail : first;
+}
+
+// Consume `len` bytes previously returned by `ringbuf_peek`.
+static inline void ringbuf_skip(ringbuf_t *rb, uint32_t len) {
+	rb->tail += len;
+}
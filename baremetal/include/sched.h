@@ -0,0 +1,33 @@
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Function run by a scheduler task.
+typedef void (*sched_fn_t)(void *cookie);
+
+// A unit of run-to-completion work.
+// Tasks are allocated by the caller and must stay valid while queued.
+typedef struct sched_task {
+	// Next task in the run queue.
+	struct sched_task *next;
+	// Function to run.
+	sched_fn_t          fn;
+	// Cookie passed to `fn`.
+	void               *cookie;
+	// Whether the task is currently in the run queue.
+	volatile bool       queued;
+} sched_task_t;
+
+// Initialise a task that will run `fn(cookie)` each time it is posted.
+void sched_task_init(sched_task_t *task, sched_fn_t fn, void *cookie);
+// Queue `task` to run once; does nothing if it is already queued.
+// May be called from interrupt handlers.
+void sched_post(sched_task_t *task);
+
+// Run all work that is due, returning whether any was done.
+bool sched_run_once();
+// Run the scheduler forever, sleeping in WFI when there is nothing to do.
+void sched_run() __attribute__((noreturn));
@@ -0,0 +1,35 @@
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Size of a SHA-256 digest in bytes.
+#define SHA256_DIGEST_LEN 32
+// Size of a SHA-256 message block in bytes.
+#define SHA256_BLOCK_LEN  64
+
+// SHA-256 hashing state.
+// When built with SHA_SOFTWARE, hashing is done on the CPU; otherwise the SHA accelerator is used.
+typedef struct {
+	// Intermediate hash value.
+	uint32_t h[8];
+	// Partial message block.
+	uint8_t  buf[SHA256_BLOCK_LEN];
+	// Number of bytes in `buf`.
+	uint32_t buf_len;
+	// Total number of bytes hashed so far.
+	uint64_t total_len;
+} sha256_ctx_t;
+
+// Initialise a SHA-256 hashing state.
+void sha256_init	(sha256_ctx_t *ctx);
+// Add `len` bytes of `data` to the hash.
+void sha256_update	(sha256_ctx_t *ctx, const void *data, size_t len);
+// Finish the hash and write the digest to `out`.
+void sha256_final	(sha256_ctx_t *ctx, uint8_t out[SHA256_DIGEST_LEN]);
+// Hash `len` bytes of `data` in one go.
+void sha256		(const void *data, size_t len, uint8_t out[SHA256_DIGEST_LEN]);
+// Check that `len` bytes of `data` hash to `digest`.
+bool sha256_verify	(const void *data, size_t len, const uint8_t digest[SHA256_DIGEST_LEN]);
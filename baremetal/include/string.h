@@ -0,0 +1,15 @@
+
+#pragma once
+
+#include <stddef.h>
+
+// GCC may emit calls to these even in freestanding code, so they must always be present.
+
+// Copy `n` bytes from `src` to `dest`; the regions must not overlap.
+void *memcpy	(void *dest, const void *src, size_t n);
+// Copy `n` bytes from `src` to `dest`; the regions may overlap.
+void *memmove	(void *dest, const void *src, size_t n);
+// Set `n` bytes at `dest` to `c`.
+void *memset	(void *dest, int c, size_t n);
+// Compare `n` bytes of `a` and `b`.
+int   memcmp	(const void *a, const void *b, size_t n);
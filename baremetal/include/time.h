@@ -3,8 +3,35 @@
 
 #include <hardware.h>
 #include <stdint.h>
+#include <stdbool.h>
+
+// The CPU cycle counter is the clock source; `time_us` extends it to 64 bits against a reference point.
+// The extension is only correct if the clock is read at least once every 2^31 cycles (about 13 seconds at 160MHz).
+// Once `timer_init` has run, a periodic timer takes care of this.
+
+// CPU cycle counter ticks per microsecond, set by `time_init`.
+extern uint32_t time_ticks_per_us;
+
+// Get the current CPU cycle count; wraps every 2^32 ticks.
+static inline uint32_t time_ticks() {
+	uint32_t ticks;
+	asm volatile ("csrr %0, 0x7e2" : "=r" (ticks));
+	return ticks;
+}
 
 // Initialise timer and watchdog subsystem.
 void time_init();
 // Get current time in microseconds.
 int64_t time_us();
+// Busy-wait for at least `us` microseconds.
+void time_delay_us(uint32_t us);
+// Busy-wait for at least `ns` nanoseconds, with a resolution of one CPU cycle.
+void time_delay_ns(uint32_t ns);
+
+// Arm the TIMG0 T0 alarm for `deadline` in `time_us` time, returning false if the deadline had already passed.
+// The alarm raises interrupt source ISR_SRC_TG0_T0 until acknowledged with `time_alarm_ack`.
+bool time_alarm_set(int64_t deadline);
+// Disarm the TIMG0 T0 alarm.
+void time_alarm_clear();
+// Acknowledge the TIMG0 T0 alarm interrupt.
+void time_alarm_ack();
@@ -0,0 +1,53 @@
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sched.h>
+
+// Timer callback function.
+typedef void (*timer_fn_t)(void *cookie);
+
+// Timer flags.
+typedef enum {
+	// Run the callback from the timer service's scheduler task (default).
+	TIMER_DEFERRED = 0,
+	// Run the callback directly from the alarm interrupt; it must be short and must not block.
+	// It may start or stop timers, which takes effect once the callback returns.
+	TIMER_ISR      = 1,
+} timer_flags_t;
+
+// A one-shot or periodic software timer.
+// Timers are allocated by the caller and must stay valid while running.
+// Named `ktimer_t` so it does not clash with the POSIX `timer_t`.
+typedef struct ktimer {
+	// Next timer in the timer queue, sorted by deadline.
+	struct ktimer *next;
+	// Callback function.
+	timer_fn_t     fn;
+	// Cookie passed to `fn`.
+	void          *cookie;
+	// Time in microseconds at which the timer expires.
+	int64_t        deadline;
+	// Period in microseconds, or 0 for a one-shot timer.
+	int64_t        period;
+	// Timer flags.
+	timer_flags_t  flags;
+	// Whether the timer is in the timer queue.
+	bool           active;
+	// Scheduler task for TIMER_DEFERRED dispatch.
+	sched_task_t   task;
+} ktimer_t;
+
+// Initialise the timer service and connect it to the TIMG0 alarm interrupt.
+// Call after `isr_init`.
+void timer_init();
+// Initialise a timer that will run `fn(cookie)` when it expires.
+void timer_setup(ktimer_t *timer, timer_fn_t fn, void *cookie, timer_flags_t flags);
+// Start `timer` to expire after `delay` microseconds and then every `period` microseconds if nonzero.
+// Restarts the timer if it was already running. May be called from interrupt handlers.
+void timer_start(ktimer_t *timer, int64_t delay, int64_t period);
+// Start `timer` to expire at `deadline` in `time_us` time and then every `period` microseconds if nonzero.
+void timer_start_at(ktimer_t *timer, int64_t deadline, int64_t period);
+// Stop `timer` if it is running. A deferred callback that was already posted may still run once.
+void timer_stop(ktimer_t *timer);
@@ -0,0 +1,40 @@
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sched.h>
+
+// UART transmit statistics.
+typedef struct {
+	// Bytes accepted for transmission.
+	uint32_t written;
+	// Bytes dropped because the transmit buffer was full.
+	uint32_t dropped;
+	// Highest number of bytes ever waiting in the transmit buffer.
+	uint32_t buffered_max;
+} uart_stats_t;
+
+// Switch UART0 transmission to the interrupt-driven buffer.
+// Until this is called, writes are synchronous. Call after `isr_init`.
+void uart_init();
+// Queue `len` bytes for transmission on UART0, dropping what does not fit.
+// May be called from interrupt handlers.
+void uart_write(const void *data, size_t len);
+// Queue one byte for transmission on UART0.
+void uart_putc(char c);
+// Write `len` bytes to UART0 directly, waiting for space in the hardware FIFO.
+void uart_write_sync(const void *data, size_t len);
+// Wait until all buffered data has been handed to the hardware FIFO.
+void uart_flush();
+// Drain the buffer and make all further writes synchronous; for use when the system is going down.
+void uart_panic();
+// Number of bytes that can be queued for UART0 without dropping any.
+// Unlimited while writes are synchronous.
+size_t uart_tx_free();
+// Post `task` once the transmit buffer is empty, or right away if it already is.
+// Only one task can wait at a time; a later call replaces the earlier one.
+void uart_tx_notify(sched_task_t *task);
+// Get the transmit statistics.
+void uart_get_stats(uart_stats_t *out);
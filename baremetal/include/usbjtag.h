@@ -0,0 +1,43 @@
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sched.h>
+
+// USB Serial/JTAG transmit statistics.
+typedef struct {
+	// Bytes accepted for transmission.
+	uint32_t written;
+	// Bytes dropped because the transmit buffer was full or no host was reading.
+	uint32_t dropped;
+	// Highest number of bytes ever waiting in the transmit buffer.
+	uint32_t buffered_max;
+	// Number of packets sent.
+	uint32_t packets;
+} usbjtag_stats_t;
+
+// Switch USB Serial/JTAG transmission to the interrupt-driven buffer.
+// Until this is called, writes are synchronous. Call after `timer_init`.
+void usbjtag_init();
+// Queue `len` bytes for transmission on the USB serial port, dropping what does not fit.
+// Data is sent in full packets, or after up to a millisecond if less than a packet is queued.
+// May be called from interrupt handlers.
+void usbjtag_write(const void *data, size_t len);
+// Queue one byte for transmission on the USB serial port.
+void usbjtag_putc(char c);
+// Write `len` bytes to the USB serial port directly, giving up if the host stops reading.
+void usbjtag_write_sync(const void *data, size_t len);
+// Wait until all buffered data has been sent, or the host stops reading.
+void usbjtag_flush();
+// Drain the buffer and make all further writes synchronous; for use when the system is going down.
+void usbjtag_panic();
+// Number of bytes that can be queued for the USB serial port without dropping any.
+// Unlimited while writes are synchronous.
+size_t usbjtag_tx_free();
+// Post `task` once the transmit buffer is empty, or right away if it already is.
+// Only one task can wait at a time; a later call replaces the earlier one.
+void usbjtag_tx_notify(sched_task_t *task);
+// Get the transmit statistics.
+void usbjtag_get_stats(usbjtag_stats_t *out);
@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+
+# Decodes binary log records (logkb) from a serial port, file or stdin back into log lines.
+# Text output on the same stream is passed through unchanged.
+# Usage: logdecode.py build/main.elf [/dev/ttyUSB0 [baudrate] | capture.bin]
+
+import os
+import re
+import struct
+import sys
+
+LOG_BIN_MAGIC = 0xB1
+
+prefix  = ["FATAL ", "ERROR ", "WARN  ", "INFO  ", "DEBUG "]
+colcode = ["\033[31m", "\033[31m", "\033[33m", "\033[32m", "\033[34m"]
+term    = "\033[0m"
+
+# Format conversions understood by the firmware's formatter.
+spec_re = re.compile(r"%([-0]*)(\*|\d*)(ll|l|z)?([diuxXscp%])")
+
+# Loaded sections of the ELF file: (address, data).
+sections = []
+
+def load_elf(path):
+    with open(path, "rb") as fd:
+        elf = fd.read()
+    if elf[:4] != b"\x7fELF" or elf[4] != 1 or elf[5] != 1:
+        raise SystemExit(f"{path}: not a 32-bit little-endian ELF file")
+    shoff,            = struct.unpack_from("<I", elf, 0x20)
+    shentsize, shnum = struct.unpack_from("<HH", elf, 0x2E)
+    for i in range(shnum):
+        _, sh_type, sh_flags, sh_addr, sh_offset, sh_size = struct.unpack_from("<IIIIII", elf, shoff + i * shentsize)
+        # Allocated sections that have contents in the file (not NOBITS).
+        if sh_flags & 2 and sh_type != 8 and sh_size:
+            sections.append((sh_addr, elf[sh_offset:sh_offset + sh_size]))
+
+def read_string(addr):
+    for base, data in sections:
+        if base <= addr < base + len(data):
+            end = data.find(b"\0", addr - base)
+            if end < 0:
+                end = len(data)
+            return data[addr - base:end].decode(errors="replace")
+    return None
+
+def cobs_decode(frame):
+    out = bytearray()
+    i   = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame) + 1:
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 0xff and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+def format_msg(fmt, args, wide):
+    out = []
+    pos = 0
+    arg = 0
+    def take():
+        nonlocal arg
+        if arg >= len(args):
+            return 0, False
+        arg += 1
+        return args[arg - 1], wide[arg - 1]
+    for m in spec_re.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, _, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if width == "*":
+            width, _ = take()
+            if width >= 0x80000000:
+                width -= 0x100000000
+            if width < 0:
+                flags += "-"
+                width  = -width
+        else:
+            width = int(width or 0)
+        val, is_wide = take()
+        if conv in "di":
+            bits = 64 if is_wide else 32
+            if val >> (bits - 1):
+                val -= 1 << bits
+            text = str(val)
+        elif conv == "u":
+            text = str(val)
+        elif conv in "xX":
+            text = format(val, conv)
+        elif conv == "p":
+            text  = f"0x{val:08x}"
+            width = 0
+        elif conv == "c":
+            text = chr(val & 0xff)
+        else:
+            text = read_string(val)
+            if text is None:
+                text = f"<0x{val:08x}>"
+        if "-" in flags:
+            text = text.ljust(width)
+        elif "0" in flags and conv in "diuxX":
+            sign = "-" if text.startswith("-") else ""
+            text = sign + text[len(sign):].rjust(width - len(sign), "0")
+        else:
+            text = text.rjust(width)
+        out.append(text)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+# Timestamps are the low 32 bits of the microsecond clock; track wraps to extend them.
+last_us = 0
+wraps   = 0
+
+def decode_record(data):
+    global last_us, wraps
+    if len(data) < 12 or len(data) % 4:
+        return None
+    words  = struct.unpack(f"<{len(data) // 4}I", data)
+    header = words[0]
+    if header >> 24 != LOG_BIN_MAGIC or (header >> 16) & 0xff != len(words):
+        return None
+    level = header & 15
+    nargs = (header >> 4) & 15
+    
+    now = words[1]
+    if now < last_us:
+        wraps += 1
+    last_us = now
+    now_ms = ((wraps << 32) + now) // 1000
+    
+    # Unpack the raw arguments using the 64-bit flags.
+    args, wide = [], []
+    i = 3
+    for n in range(nargs):
+        if (header >> (8 + n)) & 1:
+            args.append(words[i] | (words[i + 1] << 32))
+            wide.append(True)
+            i += 2
+        else:
+            args.append(words[i])
+            wide.append(False)
+            i += 1
+    
+    if words[2] == 0:
+        msg = f"<{args[0] if args else '?'} binary log records dropped>"
+    else:
+        fmt = read_string(words[2])
+        if fmt is None:
+            msg = f"<unknown format 0x{words[2]:08x}> " + " ".join(hex(a) for a in args)
+        else:
+            msg = format_msg(fmt, args, wide)
+    
+    col = colcode[level] if level < len(colcode) else ""
+    pre = prefix[level] if level < len(prefix) else "      "
+    return f"{col}[{now_ms // 1000:05d}.{now_ms % 1000:03d}] {pre}{msg}{term}\r\n"
+
+def open_input(argv):
+    if len(argv) < 3 or argv[2] == "-":
+        return sys.stdin.buffer
+    path = argv[2]
+    if path.startswith("/dev/"):
+        import serial
+        baud = int(argv[3]) if len(argv) > 3 else 115200
+        return serial.Serial(path, baud, timeout=0.1)
+    return open(path, "rb")
+
+def main(argv):
+    if len(argv) < 2:
+        raise SystemExit(f"Usage: {argv[0]} <elf> [port [baudrate] | file | -]")
+    load_elf(argv[1])
+    src = open_input(argv)
+    out = sys.stdout
+    
+    in_frame = False
+    frame    = bytearray()
+    while True:
+        chunk = src.read(256)
+        if not chunk:
+            if hasattr(src, "is_open"):
+                continue
+            break
+        text = bytearray()
+        for byte in chunk:
+            if byte == 0:
+                if in_frame and frame:
+                    # End of a frame.
+                    out.write(text.decode(errors="replace"))
+                    text.clear()
+                    record = cobs_decode(bytes(frame))
+                    line   = decode_record(record) if record is not None else None
+                    out.write(line if line is not None else f"<corrupt frame: {frame.hex()}>\r\n")
+                    frame.clear()
+                    in_frame = False
+                else:
+                    # Start of a frame; a zero right after a frame also starts the next one.
+                    in_frame = True
+            elif in_frame:
+                frame.append(byte)
+            else:
+                text.append(byte)
+        out.write(text.decode(errors="replace"))
+        out.flush()
+
+if __name__ == "__main__":
+    try:
+        main(sys.argv)
+    except KeyboardInterrupt:
+        pass
@@ -1,6 +1,7 @@
 #!/usr/bin/env python3
 
 import os
+import hashlib
 
 # Use objcopy to extract the image from the ELF file.
 os.system("riscv32-unknown-linux-gnu-objcopy -O binary build/main.elf build/main.bin")
@@ -40,3 +41,9 @@ for _ in range(seg_num):
 # Append checksum.
 fd.seek(0, 2)
 fd.write(bytes([xsum_state]))
+
+# Append SHA256 of the entire image, which the bootloader verifies.
+fd.seek(0, 0)
+digest = hashlib.sha256(fd.read()).digest()
+fd.seek(0, 2)
+fd.write(digest)
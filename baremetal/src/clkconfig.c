@@ -154,6 +154,9 @@
 // Enable bit for PCR_*_CONF_REG.
 #define PCR_CONF_ENABLE_BIT			0x0002
 
+// Keep the CPU clock running while the CPU waits in WFI, for PCR_CPU_WAITI_CONF_REG.
+#define PCR_CPU_WAIT_MODE_FORCE_ON_BIT	0x0008
+
 // Enable bit for PCR_*_SCLK_CONF_REG.
 #define PCR_CONF_SCLK_ENABLE_BIT	0x00400000
 // Clock source select mask for PCR_*_SCLK_CONF_REG.
@@ -230,3 +233,14 @@ void clkconfig_i2c0(uint32_t freq_hz, bool enable, bool reset) {
 	WRITE_REG(PCR_I2C_SCLK_CONF_REG, enable * PCR_CONF_SCLK_ENABLE_BIT + clk_compute_div(FREQ_XTAL_CLK, freq_hz));
 	WRITE_REG(PCR_I2C_CONF_REG, PCR_CONF_ENABLE_BIT + reset * PCR_CONF_RESET_BIT);
 }
+
+// Configure SHA accelerator clock.
+void clkconfig_sha(bool enable, bool reset) {
+	WRITE_REG(PCR_SHA_CONF_REG, enable * PCR_CONF_ENABLE_BIT + reset * PCR_CONF_RESET_BIT);
+}
+
+// Configure whether the CPU clock keeps running while the CPU waits in WFI.
+void clkconfig_cpu_waiti(bool force_on) {
+	uint32_t conf = READ_REG(PCR_CPU_WAITI_CONF_REG) & ~PCR_CPU_WAIT_MODE_FORCE_ON_BIT;
+	WRITE_REG(PCR_CPU_WAITI_CONF_REG, conf | force_on * PCR_CPU_WAIT_MODE_FORCE_ON_BIT);
+}
@@ -0,0 +1,99 @@
+
+#include <console.h>
+#include <uart.h>
+#include <usbjtag.h>
+
+// Currently selected backend.
+static console_backend_t backend = CONSOLE_DEFAULT;
+// Whether `console_init` has been called.
+static bool              initialised;
+// Whether the UART backend has been switched to interrupt-driven output.
+static bool              uart_ready;
+// Whether the USB Serial/JTAG backend has been switched to interrupt-driven output.
+static bool              usbjtag_ready;
+
+
+
+// Switch the selected backend to interrupt-driven output, leaving the other one untouched.
+static void console_init_backend() {
+	if (backend == CONSOLE_USB_JTAG && !usbjtag_ready) {
+		usbjtag_init();
+		usbjtag_ready = true;
+	} else if (backend == CONSOLE_UART && !uart_ready) {
+		uart_init();
+		uart_ready = true;
+	}
+}
+
+
+
+// Switch the selected console backend to interrupt-driven output. Call after `timer_init`.
+void console_init() {
+	initialised = true;
+	console_init_backend();
+}
+
+// Select the backend console output goes to.
+void console_select(console_backend_t new_backend) {
+	if (new_backend == backend) return;
+	// Let the old backend finish so output does not get reordered.
+	console_flush();
+	backend = new_backend;
+	if (initialised) console_init_backend();
+}
+
+// Get the backend console output goes to.
+console_backend_t console_selected() {
+	return backend;
+}
+
+// Write `len` bytes to the console. May be called from interrupt handlers.
+void console_write(const void *data, size_t len) {
+	if (backend == CONSOLE_USB_JTAG) {
+		usbjtag_write(data, len);
+	} else {
+		uart_write(data, len);
+	}
+}
+
+// Write one byte to the console.
+void console_putc(char c) {
+	console_write(&c, 1);
+}
+
+// Number of bytes that can be written to the console without dropping any.
+size_t console_tx_free() {
+	if (backend == CONSOLE_USB_JTAG) {
+		return usbjtag_tx_free();
+	} else {
+		return uart_tx_free();
+	}
+}
+
+// Post `task` once the console's transmit buffer is empty, or right away if it already is.
+// Only one task can wait at a time; a later call replaces the earlier one.
+void console_tx_notify(sched_task_t *task) {
+	if (backend == CONSOLE_USB_JTAG) {
+		usbjtag_tx_notify(task);
+	} else {
+		uart_tx_notify(task);
+	}
+}
+
+// Wait until buffered console output has been sent.
+void console_flush() {
+	if (backend == CONSOLE_USB_JTAG) {
+		usbjtag_flush();
+	} else {
+		uart_flush();
+	}
+}
+
+// Drain the console and make all further output synchronous; for use when the system is going down.
+void console_panic() {
+	if (backend == CONSOLE_USB_JTAG) {
+		usbjtag_panic();
+	} else {
+		uart_panic();
+	}
+}
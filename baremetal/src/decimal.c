@@ -0,0 +1,65 @@
+
+#include <decimal.h>
+#include <int64.h>
+
+// ASCII digit pairs for 00 to 99.
+static const char pairs[200] =
+	"00010203040506070809" "10111213141516171819" "20212223242526272829" "30313233343536373839"
+	"40414243444546474849" "50515253545556575859" "60616263646566676869" "70717273747576777879"
+	"80818283848586878889" "90919293949596979899";
+
+// Exact `val / 100` for any 32-bit value, using a multiply instead of a divide.
+static inline uint32_t div100(uint32_t val) {
+	return ((uint64_t) val * 0x51EB851F) >> 37;
+}
+
+// Write exactly 8 digits of `val` (below 10^8) ending at `end`, with leading zeroes.
+static char *decimal_8(uint32_t val, char *end) {
+	for (int i = 0; i < 4; i++) {
+		uint32_t q = div100(val);
+		uint32_t r = val - q * 100;
+		end -= 2;
+		end[0] = pairs[2 * r];
+		end[1] = pairs[2 * r + 1];
+		val = q;
+	}
+	return end;
+}
+
+// Convert `val` to decimal ASCII, writing backwards so the last digit is just before `end`.
+// Returns a pointer to the first digit; there is no terminator and at least one digit is written.
+char *decimal_u32(uint32_t val, char *end) {
+	while (val >= 100) {
+		uint32_t q = div100(val);
+		uint32_t r = val - q * 100;
+		end -= 2;
+		end[0] = pairs[2 * r];
+		end[1] = pairs[2 * r + 1];
+		val = q;
+	}
+	if (val >= 10) {
+		end -= 2;
+		end[0] = pairs[2 * val];
+		end[1] = pairs[2 * val + 1];
+	} else {
+		*--end = '0' + val;
+	}
+	return end;
+}
+
+// Convert `val` to decimal ASCII, writing backwards so the last digit is just before `end`.
+// Returns a pointer to the first digit; `end` must have room for DECIMAL_MAX_DIGITS before it.
+char *decimal_u64(uint64_t val, char *end) {
+	// Most values fit in 32 bits; stay on 32-bit arithmetic for those.
+	if (!(val >> 32)) return decimal_u32(val, end);
+	
+	// Peel off 8 digits at a time until the rest fits in 32 bits.
+	uint64_t q = int64_udiv100000000(val);
+	end = decimal_8(val - q * 100000000, end);
+	if (q >> 32) {
+		uint64_t q2 = int64_udiv100000000(q);
+		end = decimal_8(q - q2 * 100000000, end);
+		q   = q2;
+	}
+	return decimal_u32(q, end);
+}
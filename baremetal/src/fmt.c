@@ -0,0 +1,168 @@
+
+#include <fmt.h>
+#include <decimal.h>
+#include <stdbool.h>
+
+// Output buffer state.
+typedef struct {
+	// Output buffer.
+	char  *buf;
+	// Capacity excluding the terminating NUL.
+	size_t cap;
+	// Current length.
+	size_t len;
+} fmt_out_t;
+
+// Append a character, dropping it if the buffer is full.
+static inline void fmt_putc(fmt_out_t *out, char c) {
+	if (out->len < out->cap) out->buf[out->len] = c;
+	out->len ++;
+}
+
+// Append `len` characters padded to `width`.
+static void fmt_field(fmt_out_t *out, const char *str, size_t len, int width, bool left) {
+	int pad = width > (int) len ? width - (int) len : 0;
+	if (!left) while (pad-- > 0) fmt_putc(out, ' ');
+	for (size_t i = 0; i < len; i++) fmt_putc(out, str[i]);
+	if (left) while (pad-- > 0) fmt_putc(out, ' ');
+}
+
+// Convert `val` to hexadecimal at the end of `tmp`, returning a pointer to the first significant digit.
+static char *fmt_hex(uint64_t val, char tmp[16], bool upper) {
+	const char *tab = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	char *ptr = tmp + 16;
+	do {
+		*--ptr = tab[val & 15];
+		val >>= 4;
+	} while (val);
+	return ptr;
+}
+
+// Append a number with optional sign, zero padding and field width.
+static void fmt_number(fmt_out_t *out, const char *digits, size_t len, bool neg, int width, bool left, bool zero) {
+	size_t total = len + neg;
+	int    pad   = width > (int) total ? width - (int) total : 0;
+	if (!left && !zero) while (pad-- > 0) fmt_putc(out, ' ');
+	if (neg) fmt_putc(out, '-');
+	if (!left && zero) while (pad-- > 0) fmt_putc(out, '0');
+	for (size_t i = 0; i < len; i++) fmt_putc(out, digits[i]);
+	if (left) while (pad-- > 0) fmt_putc(out, ' ');
+}
+
+// Format into `buf` of `size` bytes, truncating if needed, and return the length without the terminating NUL.
+size_t fmt_vformat(char *buf, size_t size, const char *fmt, va_list args) {
+	if (!size) return 0;
+	fmt_out_t out = { buf, size - 1, 0 };
+	
+	while (*fmt) {
+		if (*fmt != '%') {
+			fmt_putc(&out, *fmt++);
+			continue;
+		}
+		fmt ++;
+		
+		// Flags.
+		bool left = false, zero = false;
+		while (*fmt == '-' || *fmt == '0') {
+			if (*fmt == '-') left = true;
+			else zero = true;
+			fmt ++;
+		}
+		
+		// Field width.
+		int width = 0;
+		if (*fmt == '*') {
+			width = va_arg(args, int);
+			if (width < 0) {
+				left  = true;
+				width = -width;
+			}
+			fmt ++;
+		} else {
+			while (*fmt >= '0' && *fmt <= '9') {
+				width = width * 10 + *fmt++ - '0';
+			}
+		}
+		
+		// Length modifiers; long and size_t are 32-bit here.
+		bool wide = false;
+		if (*fmt == 'l') {
+			fmt ++;
+			if (*fmt == 'l') {
+				wide = true;
+				fmt ++;
+			}
+		} else if (*fmt == 'z') {
+			fmt ++;
+		}
+		
+		char     tmp[DECIMAL_MAX_DIGITS];
+		char    *digits;
+		uint64_t uval;
+		int64_t  sval;
+		switch (*fmt) {
+			case 'd':
+			case 'i':
+				sval   = wide ? va_arg(args, int64_t) : va_arg(args, int32_t);
+				uval   = sval < 0 ? -(uint64_t) sval : (uint64_t) sval;
+				digits = decimal_u64(uval, tmp + DECIMAL_MAX_DIGITS);
+				fmt_number(&out, digits, tmp + DECIMAL_MAX_DIGITS - digits, sval < 0, width, left, zero);
+				break;
+			case 'u':
+				uval   = wide ? va_arg(args, uint64_t) : va_arg(args, uint32_t);
+				digits = decimal_u64(uval, tmp + DECIMAL_MAX_DIGITS);
+				fmt_number(&out, digits, tmp + DECIMAL_MAX_DIGITS - digits, false, width, left, zero);
+				break;
+			case 'x':
+			case 'X':
+				uval   = wide ? va_arg(args, uint64_t) : va_arg(args, uint32_t);
+				digits = fmt_hex(uval, tmp, *fmt == 'X');
+				fmt_number(&out, digits, tmp + 16 - digits, false, width, left, zero);
+				break;
+			case 'p':
+				uval = (size_t) va_arg(args, void *);
+				fmt_putc(&out, '0');
+				fmt_putc(&out, 'x');
+				digits = fmt_hex(uval, tmp, false);
+				fmt_number(&out, digits, tmp + 16 - digits, false, sizeof(void *) * 2, false, true);
+				break;
+			case 's': {
+				const char *str = va_arg(args, const char *);
+				if (!str) str = "(null)";
+				size_t len = 0;
+				while (str[len]) len ++;
+				fmt_field(&out, str, len, width, left);
+			} break;
+			case 'c': {
+				char c = va_arg(args, int);
+				fmt_field(&out, &c, 1, width, left);
+			} break;
+			case '%':
+				fmt_putc(&out, '%');
+				break;
+			case 0:
+				// Format string ends in the middle of a conversion.
+				fmt --;
+				break;
+			default:
+				// Unknown conversion; print it as-is.
+				fmt_putc(&out, '%');
+				fmt_putc(&out, *fmt);
+				break;
+		}
+		fmt ++;
+	}
+	
+	if (out.len > out.cap) out.len = out.cap;
+	buf[out.len] = 0;
+	return out.len;
+}
+
+// Format into `buf` of `size` bytes, truncating if needed, and return the length without the terminating NUL.
+size_t fmt_format(char *buf, size_t size, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	size_t len = fmt_vformat(buf, size, fmt, args);
+	va_end(args);
+	return len;
+}
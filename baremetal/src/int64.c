@@ -0,0 +1,142 @@
+
+#include <int64.h>
+#include <stdbool.h>
+
+// 64-bit division runtime for RV32, which only has 32-bit divide instructions.
+// Nothing in here may use a 64-bit `/` or `%`, because the compiler would turn those into calls back into this file.
+// Division by zero follows the RISC-V convention: the quotient is all ones and the remainder is the dividend.
+
+uint64_t __udivdi3(uint64_t a, uint64_t b);
+uint64_t __umoddi3(uint64_t a, uint64_t b);
+int64_t  __divdi3 (int64_t  a, int64_t  b);
+int64_t  __moddi3 (int64_t  a, int64_t  b);
+
+
+
+// Count leading zeroes of a nonzero value; __builtin_clz would be a libcall without Zbb.
+static inline int clz32(uint32_t x) {
+	int n = 0;
+	if (!(x & 0xffff0000)) { n += 16; x <<= 16; }
+	if (!(x & 0xff000000)) { n +=  8; x <<=  8; }
+	if (!(x & 0xf0000000)) { n +=  4; x <<=  4; }
+	if (!(x & 0xc0000000)) { n +=  2; x <<=  2; }
+	if (!(x & 0x80000000)) { n +=  1; }
+	return n;
+}
+
+// Divide the 64-bit value `u1:u0` by `v`, where `u1 < v`, in two 16-bit steps on the 32-bit divider.
+// Normalised long division from Hacker's Delight (divlu2).
+static uint32_t divlu(uint32_t u1, uint32_t u0, uint32_t v, uint32_t *rem) {
+	const uint32_t b = 0x10000;
+	
+	// Normalise so the top bit of the divisor is set; the quotient digit estimates are then off by at most 2.
+	int s = clz32(v);
+	v <<= s;
+	uint32_t vn1  = v >> 16;
+	uint32_t vn0  = v & 0xffff;
+	uint32_t un32 = s ? (u1 << s) | (u0 >> (32 - s)) : u1;
+	uint32_t un10 = u0 << s;
+	uint32_t un1  = un10 >> 16;
+	uint32_t un0  = un10 & 0xffff;
+	
+	// First quotient digit.
+	uint32_t q1   = un32 / vn1;
+	uint32_t rhat = un32 - q1 * vn1;
+	while (q1 >= b || q1 * vn0 > b * rhat + un1) {
+		q1   --;
+		rhat += vn1;
+		if (rhat >= b) break;
+	}
+	uint32_t un21 = un32 * b + un1 - q1 * v;
+	
+	// Second quotient digit.
+	uint32_t q0 = un21 / vn1;
+	rhat = un21 - q0 * vn1;
+	while (q0 >= b || q0 * vn0 > b * rhat + un0) {
+		q0   --;
+		rhat += vn1;
+		if (rhat >= b) break;
+	}
+	
+	*rem = (un21 * b + un0 - q0 * v) >> s;
+	return q1 * b + q0;
+}
+
+// Unsigned 64-bit division and modulo.
+static uint64_t udivmod64(uint64_t u, uint64_t v, uint64_t *rem) {
+	uint32_t u1 = u >> 32, u0 = u;
+	uint32_t v1 = v >> 32, v0 = v;
+	
+	if (!v1) {
+		if (!v0) {
+			*rem = u;
+			return UINT64_MAX;
+		}
+		if (!u1) {
+			// 32 by 32 bits: one hardware divide.
+			*rem = u0 % v0;
+			return u0 / v0;
+		}
+		uint32_t r;
+		if (u1 < v0) {
+			// 64 by 32 bits with a 32-bit quotient.
+			uint32_t q = divlu(u1, u0, v0, &r);
+			*rem = r;
+			return q;
+		}
+		// 64 by 32 bits with a 64-bit quotient: divide the high word first.
+		uint32_t q1 = u1 / v0;
+		uint32_t k  = u1 - q1 * v0;
+		uint32_t q0 = divlu(k, u0, v0, &r);
+		*rem = r;
+		return ((uint64_t) q1 << 32) | q0;
+	}
+	
+	// 64 by 64 bits: the quotient fits in 32 bits. Estimate it from the normalised top word
+	// of the divisor (Hacker's Delight divDU), which is at most one too small after the decrement.
+	int      n   = clz32(v1);
+	uint32_t vn1 = (v << n) >> 32;
+	uint64_t u_2 = u >> 1;
+	uint32_t r;
+	uint32_t q1  = divlu(u_2 >> 32, u_2, vn1, &r);
+	uint32_t q0  = ((uint64_t) q1 << n) >> 31;
+	if (q0) q0 --;
+	uint64_t rest = u - (uint64_t) q0 * v;
+	if (rest >= v) {
+		q0   ++;
+		rest -= v;
+	}
+	*rem = rest;
+	return q0;
+}
+
+
+
+// Unsigned 64-bit division.
+uint64_t __udivdi3(uint64_t a, uint64_t b) {
+	uint64_t rem;
+	return udivmod64(a, b, &rem);
+}
+
+// Unsigned 64-bit modulo.
+uint64_t __umoddi3(uint64_t a, uint64_t b) {
+	uint64_t rem;
+	udivmod64(a, b, &rem);
+	return rem;
+}
+
+// Signed 64-bit division; rounds towards zero.
+int64_t __divdi3(int64_t a, int64_t b) {
+	if (!b) return -1;
+	bool     neg = (a < 0) != (b < 0);
+	uint64_t rem;
+	uint64_t q   = udivmod64(a < 0 ? -(uint64_t) a : (uint64_t) a, b < 0 ? -(uint64_t) b : (uint64_t) b, &rem);
+	return (int64_t) (neg ? -q : q);
+}
+
+// Signed 64-bit modulo; the result has the sign of the dividend.
+int64_t __moddi3(int64_t a, int64_t b) {
+	uint64_t rem;
+	udivmod64(a < 0 ? -(uint64_t) a : (uint64_t) a, b < 0 ? -(uint64_t) b : (uint64_t) b, &rem);
+	return (int64_t) (a < 0 ? -rem : rem);
+}
@@ -0,0 +1,287 @@
+
+#include <isr.h>
+#include <hardware.h>
+#include <rawprint.h>
+#include <time.h>
+#include <console.h>
+#include <log.h>
+
+// CPU interrupt enable register (Access: R/W)
+#define INTPRI_CORE0_CPU_INT_ENABLE_REG		(INTPRI_BASE + 0x0000)
+// CPU interrupt type register, 1 for edge-triggered (Access: R/W)
+#define INTPRI_CORE0_CPU_INT_TYPE_REG		(INTPRI_BASE + 0x0004)
+// CPU interrupt pending status register (Access: RO)
+#define INTPRI_CORE0_CPU_INT_EIP_STATUS_REG	(INTPRI_BASE + 0x0008)
+// CPU interrupt 0-31 priority register (Access: R/W)
+#define INTPRI_CORE0_CPU_INT_PRI_N_REG(N)	(INTPRI_BASE + 0x000C + 4 * (N))
+// CPU interrupt priority threshold register (Access: R/W)
+#define INTPRI_CORE0_CPU_INT_THRESH_REG		(INTPRI_BASE + 0x008C)
+// Software interrupt 0 trigger register (Access: R/W)
+#define INTPRI_CPU_INTR_FROM_CPU_0_REG		(INTPRI_BASE + 0x0090)
+// CPU interrupt clear register for edge-triggered interrupts (Access: R/W)
+#define INTPRI_CORE0_CPU_INT_CLEAR_REG		(INTPRI_BASE + 0x00A8)
+
+// Interrupt matrix source 0-76 mapping register (Access: R/W)
+#define INTMTX_CORE0_N_INTR_MAP_REG(N)		(INTMTX_BASE + 4 * (N))
+
+// Vector table defined in isr.S.
+extern const char __isr_vector_table[];
+// Cycle count at the most recent trap entry, written by isr.S.
+extern volatile uint32_t isr_entry_cycles;
+
+// Registered handler for one CPU interrupt channel.
+typedef struct {
+	// Handler function, NULL if none.
+	isr_handler_t handler;
+	// Cookie passed to the handler.
+	void         *cookie;
+	// Cycle count from `isr_latency_mark`, valid if `marked`.
+	uint32_t      mark;
+	// Whether a latency measurement is pending.
+	bool          marked;
+	// Latency and duration statistics.
+	isr_stats_t   stats;
+} isr_channel_t;
+
+static isr_channel_t isr_channels[ISR_CHANNEL_COUNT];
+// Bitmask of edge-triggered channels.
+static uint32_t      isr_edge_mask;
+
+// Check a CPU interrupt channel number.
+static bool isr_check_channel(badge_err_t *ec, int channel) {
+	if (channel < 1 || channel >= ISR_CHANNEL_COUNT) {
+		if (ec) ec->cause = ECAUSE_RANGE;
+		if (ec) ec->location = ELOC_UNKNOWN;
+		return false;
+	}
+	return true;
+}
+
+
+
+// Initialise the interrupt subsystem: install the trap vector, unroute all sources and enable interrupts globally.
+void isr_init() {
+	isr_global_disable();
+	
+	// Disable and unroute everything the bootloader may have left behind.
+	WRITE_REG(INTPRI_CORE0_CPU_INT_ENABLE_REG, 0);
+	asm volatile ("csrw mie, x0");
+	for (int i = 0; i < ISR_SOURCE_COUNT; i++) {
+		WRITE_REG(INTMTX_CORE0_N_INTR_MAP_REG(i), 0);
+	}
+	WRITE_REG(INTPRI_CORE0_CPU_INT_TYPE_REG, 0);
+	isr_edge_mask = 0;
+	
+	// Let every priority from 1 upwards through.
+	WRITE_REG(INTPRI_CORE0_CPU_INT_THRESH_REG, 1);
+	
+	// Install the vector table in vectored mode.
+	asm volatile ("csrw mtvec, %0" :: "r" ((uint32_t) __isr_vector_table | 1));
+	
+	isr_global_enable();
+}
+
+// Register `handler` for CPU interrupt `channel`, or unregister it with NULL.
+void isr_set_handler(badge_err_t *ec, int channel, isr_handler_t handler, void *cookie) {
+	if (!isr_check_channel(ec, channel)) return;
+	bool ie = isr_global_disable();
+	isr_channels[channel].handler = handler;
+	isr_channels[channel].cookie  = cookie;
+	isr_global_restore(ie);
+	if (ec) ec->cause = 0;
+}
+
+// Route interrupt matrix `source` to CPU interrupt `channel`, or disconnect it with channel 0.
+void isr_route(badge_err_t *ec, int source, int channel) {
+	if (source < 0 || source >= ISR_SOURCE_COUNT || channel < 0 || channel >= ISR_CHANNEL_COUNT) {
+		if (ec) ec->cause = ECAUSE_RANGE;
+		if (ec) ec->location = ELOC_UNKNOWN;
+		return;
+	}
+	WRITE_REG(INTMTX_CORE0_N_INTR_MAP_REG(source), channel);
+	if (ec) ec->cause = 0;
+}
+
+// Set the priority of CPU interrupt `channel` (1 to ISR_PRIORITY_MAX; 0 never fires).
+void isr_set_priority(badge_err_t *ec, int channel, int priority) {
+	if (!isr_check_channel(ec, channel)) return;
+	if (priority < 0 || priority > ISR_PRIORITY_MAX) {
+		if (ec) ec->cause = ECAUSE_RANGE;
+		if (ec) ec->location = ELOC_UNKNOWN;
+		return;
+	}
+	WRITE_REG(INTPRI_CORE0_CPU_INT_PRI_N_REG(channel), priority);
+	if (ec) ec->cause = 0;
+}
+
+// Set whether CPU interrupt `channel` is edge-triggered instead of level-triggered.
+void isr_set_edge(badge_err_t *ec, int channel, bool edge) {
+	if (!isr_check_channel(ec, channel)) return;
+	bool ie = isr_global_disable();
+	if (edge) isr_edge_mask |=  1 << channel;
+	else      isr_edge_mask &= ~(1 << channel);
+	WRITE_REG(INTPRI_CORE0_CPU_INT_TYPE_REG, isr_edge_mask);
+	isr_global_restore(ie);
+	if (ec) ec->cause = 0;
+}
+
+// Enable or disable CPU interrupt `channel`.
+void isr_enable(badge_err_t *ec, int channel, bool enable) {
+	if (!isr_check_channel(ec, channel)) return;
+	bool     ie   = isr_global_disable();
+	uint32_t mask = READ_REG(INTPRI_CORE0_CPU_INT_ENABLE_REG);
+	if (enable) {
+		mask |= 1 << channel;
+		asm volatile ("csrs mie, %0" :: "r" (1 << channel));
+	} else {
+		mask &= ~(1 << channel);
+		asm volatile ("csrc mie, %0" :: "r" (1 << channel));
+	}
+	WRITE_REG(INTPRI_CORE0_CPU_INT_ENABLE_REG, mask);
+	isr_global_restore(ie);
+	if (ec) ec->cause = 0;
+}
+
+// Set the priority threshold; interrupts with a lower priority are masked.
+void isr_set_threshold(badge_err_t *ec, int threshold) {
+	if (threshold < 0 || threshold > ISR_PRIORITY_MAX + 1) {
+		if (ec) ec->cause = ECAUSE_RANGE;
+		if (ec) ec->location = ELOC_UNKNOWN;
+		return;
+	}
+	WRITE_REG(INTPRI_CORE0_CPU_INT_THRESH_REG, threshold);
+	if (ec) ec->cause = 0;
+}
+
+
+
+// Called from isr.S for every interrupt.
+void isr_dispatch(uint32_t mcause) {
+	int            channel = mcause & 31;
+	isr_channel_t *ch      = &isr_channels[channel];
+	
+	// Edge-triggered interrupts stay pending until cleared.
+	if ((isr_edge_mask >> channel) & 1) {
+		WRITE_REG(INTPRI_CORE0_CPU_INT_CLEAR_REG, 1 << channel);
+		WRITE_REG(INTPRI_CORE0_CPU_INT_CLEAR_REG, 0);
+	}
+	
+	// Latency hook: time from the mark to trap entry.
+	if (ch->marked) {
+		uint32_t latency = isr_entry_cycles - ch->mark;
+		ch->stats.latency_last = latency;
+		if (latency > ch->stats.latency_max) ch->stats.latency_max = latency;
+		ch->marked = false;
+	}
+	
+	uint32_t start = time_ticks();
+	if (ch->handler) {
+		ch->handler(channel, ch->cookie);
+	} else {
+		// Nobody wants this interrupt; stop it from firing again.
+		uint32_t mask = READ_REG(INTPRI_CORE0_CPU_INT_ENABLE_REG);
+		WRITE_REG(INTPRI_CORE0_CPU_INT_ENABLE_REG, mask & ~(1 << channel));
+	}
+	uint32_t duration = time_ticks() - start;
+	
+	ch->stats.count ++;
+	if (duration > ch->stats.duration_max) ch->stats.duration_max = duration;
+}
+
+// Names of the RISC-V exception causes.
+static const char *const isr_exc_names[] = {
+	"Instruction address misaligned",
+	"Instruction access fault",
+	"Illegal instruction",
+	"Breakpoint",
+	"Load address misaligned",
+	"Load access fault",
+	"Store address misaligned",
+	"Store access fault",
+	"Environment call from U-mode",
+	"Environment call from S-mode",
+	"Reserved",
+	"Environment call from M-mode",
+};
+
+// Called from isr.S for every exception; prints the cause and halts.
+void isr_exception(const uint32_t *regs) __attribute__((noreturn));
+void isr_exception(const uint32_t *regs) {
+	uint32_t mcause, mtval;
+	asm volatile ("csrr %0, mcause" : "=r" (mcause));
+	asm volatile ("csrr %0, mtval" : "=r" (mtval));
+	
+	// Buffered output would never drain now.
+	console_panic();
+	// Get the binary log out too; the records leading up to the crash matter most.
+	logkb_flush();
+	
+	rawprint("\033[31mFATAL ");
+	if (mcause < sizeof(isr_exc_names) / sizeof(isr_exc_names[0])) {
+		rawprint(isr_exc_names[mcause]);
+	} else {
+		rawprint("Exception ");
+		rawprintudec(mcause, 1);
+	}
+	rawprint(" at 0x");
+	rawprinthex(regs[0], 8);
+	rawprint(", mtval 0x");
+	rawprinthex(mtval, 8);
+	rawprint("\033[0m\r\n");
+	
+	// Register dump, x1-x31.
+	for (int i = 1; i < 32; i++) {
+		rawprint(" x");
+		rawprintudec(i, 2);
+		rawprint(" 0x");
+		rawprinthex(regs[i], 8);
+		if (i % 4 == 3) rawprint("\r\n");
+	}
+	rawprint("\r\n");
+	
+	while (1);
+}
+
+
+
+// Latency hook: record that an interrupt on `channel` is expected from now on, e.g. right before triggering it.
+// The next trap on `channel` will record the cycles between this call and trap entry.
+void isr_latency_mark(int channel) {
+	if (channel < 1 || channel >= ISR_CHANNEL_COUNT) return;
+	bool ie = isr_global_disable();
+	isr_channels[channel].marked = true;
+	isr_channels[channel].mark   = time_ticks();
+	isr_global_restore(ie);
+}
+
+// Get the statistics of CPU interrupt `channel`.
+void isr_get_stats(badge_err_t *ec, int channel, isr_stats_t *out) {
+	if (!isr_check_channel(ec, channel)) return;
+	bool ie = isr_global_disable();
+	*out = isr_channels[channel].stats;
+	isr_global_restore(ie);
+	if (ec) ec->cause = 0;
+}
+
+// Acknowledge the self-test software interrupt.
+static void isr_selftest_handler(int channel, void *cookie) {
+	WRITE_REG(INTPRI_CPU_INTR_FROM_CPU_0_REG, 0);
+}
+
+// Measure interrupt entry latency in cycles using a software interrupt on ISR_CHANNEL_SELFTEST.
+uint32_t isr_measure_latency() {
+	isr_set_handler(NULL, ISR_CHANNEL_SELFTEST, isr_selftest_handler, NULL);
+	isr_set_priority(NULL, ISR_CHANNEL_SELFTEST, 1);
+	isr_route(NULL, ISR_SRC_FROM_CPU_0, ISR_CHANNEL_SELFTEST);
+	isr_enable(NULL, ISR_CHANNEL_SELFTEST, true);
+	
+	volatile isr_stats_t *stats = &isr_channels[ISR_CHANNEL_SELFTEST].stats;
+	uint32_t count = stats->count;
+	isr_latency_mark(ISR_CHANNEL_SELFTEST);
+	WRITE_REG(INTPRI_CPU_INTR_FROM_CPU_0_REG, 1);
+	while (stats->count == count);
+	
+	isr_enable(NULL, ISR_CHANNEL_SELFTEST, false);
+	isr_route(NULL, ISR_SRC_FROM_CPU_0, 0);
+	return stats->latency_last;
+}
@@ -1,11 +1,16 @@
 
 #include <log.h>
-#include <rawprint.h>
+#include <fmt.h>
+#include <time.h>
+#include <console.h>
+#include <int64.h>
 
-typedef __builtin_va_list va_list;
-#define va_start(x) __buitlin_va_start(x)
-#define va_end(x) __builtin_va_end(x)
-#define va_arg(x,y) __builtin_va_arg(x,y)
+// With LOG_BINARY, log.h turns these into macros; the text versions are still defined here.
+#undef logk
+#undef logkf
+
+// Maximum length of one log line including colour codes; longer messages are truncated.
+#define LOG_LINE_MAX 256
 
 #define isvalidlevel(level) (level >= 0 && level < 5)
 
@@ -27,23 +32,81 @@ static const char *colcode[] = {
 
 static const char *term = "\033[0m\r\n";
 
+// Length of `term` without the terminator.
+#define TERM_LEN 6
+
+// Format the start of a log line: colour, timestamp and level.
+static size_t log_header(char *line, log_level_t level) {
+	uint64_t now    = int64_udiv1000(time_us());
+	uint64_t secs   = int64_udiv1000(now);
+	uint32_t millis = now - secs * 1000;
+	return fmt_format(line, LOG_LINE_MAX - TERM_LEN, "%s[%05llu.%03u] %s",
+		isvalidlevel(level) ? colcode[level] : "",
+		secs, millis,
+		isvalidlevel(level) ? prefix[level] : "      ");
+}
+
+// Number of bytes character `i` of `line` takes once line endings are converted to "\r\n".
+// A lone '\r' or '\n' becomes "\r\n" and the '\n' of an existing "\r\n" is absorbed by its '\r'.
+static inline size_t log_crlf_width(const char *line, size_t start, size_t i) {
+	if (line[i] == '\r') return 2;
+	if (line[i] == '\n') return i > start && line[i-1] == '\r' ? 0 : 2;
+	return 1;
+}
+
+// Convert the line endings of the message in `line[start..len)` in place, like `rawprint` does,
+// and return the new length. Whatever no longer fits before the terminator is dropped.
+static size_t log_crlf(char *line, size_t start, size_t len) {
+	// Find how much of the message fits once converted.
+	size_t end = start, out = start;
+	for (; end < len; end++) {
+		size_t width = log_crlf_width(line, start, end);
+		if (out + width > LOG_LINE_MAX - TERM_LEN) break;
+		out += width;
+	}
+	if (out == end) return out;
+	
+	// Expand back to front so that nothing is overwritten before it is read.
+	size_t total = out;
+	while (end > start) {
+		end --;
+		size_t width = log_crlf_width(line, start, end);
+		if (width == 2) {
+			line[--out] = '\n';
+			line[--out] = '\r';
+		} else if (width == 1) {
+			line[--out] = line[end];
+		}
+	}
+	return total;
+}
+
+// Terminate a log line and write it to the console in one go.
+static void log_emit(char *line, size_t len) {
+	for (int i = 0; i < TERM_LEN; i++) {
+		line[len++] = term[i];
+	}
+	console_write(line, len);
+}
+
 // Print an unformatted message.
 void logk(log_level_t level, const char *msg) {
-	if (isvalidlevel(level)) rawprint(colcode[level]);
-	rawprintuptime();
-	rawputc(' ');
-	if (isvalidlevel(level)) rawprint(prefix[level]);
-	else rawprint("      ");
-	rawprint(msg);
-	rawprint(term);
+	char   line[LOG_LINE_MAX];
+	size_t start = log_header(line, level);
+	size_t len   = start;
+	while (*msg && len < LOG_LINE_MAX - TERM_LEN) {
+		line[len++] = *msg++;
+	}
+	log_emit(line, log_crlf(line, start, len));
 }
 
 // Print a formatted message.
 void logkf(log_level_t level, const char *msg, ...) {
-	if (isvalidlevel(level)) rawprint(colcode[level]);
-	rawprintuptime();
-	if (isvalidlevel(level)) rawprint(prefix[level]);
-	else rawprint("      ");
-	rawprint(msg);
-	rawprint(term);
+	char    line[LOG_LINE_MAX];
+	size_t  start = log_header(line, level);
+	va_list args;
+	va_start(args, msg);
+	size_t  len   = start + fmt_vformat(line + start, LOG_LINE_MAX - TERM_LEN - start, msg, args);
+	va_end(args);
+	log_emit(line, log_crlf(line, start, len));
 }
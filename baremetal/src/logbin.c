@@ -0,0 +1,185 @@
+
+#include <log.h>
+#include <time.h>
+#include <isr.h>
+#include <sched.h>
+#include <console.h>
+#include <stdarg.h>
+
+// Size of the binary log buffer in words; must be a power of two.
+#define LOGBIN_BUF_WORDS	1024
+// Longest possible record in words: header, timestamp, format and 8 64-bit arguments.
+#define LOGBIN_RECORD_MAX	19
+// Worst-case size of the console frame for a record of `words` words:
+// the data, one COBS code byte (records are shorter than 254 bytes) and two delimiters.
+#define LOGBIN_FRAME_SIZE(words)	((words) * 4 + 3)
+// Maximum number of records the drain task writes before yielding to other tasks.
+#define LOGBIN_DRAIN_BATCH	16
+// Header of a dropped-records marker: a one-argument record without a format string.
+#define LOGBIN_LOST_HEADER	(((uint32_t) LOG_BIN_MAGIC << 24) + (4 << 16) + (1 << 4) + LOG_WARN)
+
+
+
+// Record storage.
+static uint32_t          logbin_buf[LOGBIN_BUF_WORDS];
+// Write index, in words.
+static volatile uint32_t logbin_head;
+// Read index, in words.
+static volatile uint32_t logbin_tail;
+// Records dropped since the last dropped-records marker was stored.
+static uint32_t          logbin_lost;
+// Records dropped in total.
+static uint32_t          logbin_lost_total;
+
+
+
+// Append one word to the buffer; the caller has checked for space.
+static inline void logbin_put(uint32_t word) {
+	logbin_buf[logbin_head++ & (LOGBIN_BUF_WORDS - 1)] = word;
+}
+
+// COBS-encode `len` bytes and write them to the console as one zero-delimited frame.
+static void logbin_send_frame(const uint8_t *data, size_t len) {
+	uint8_t frame[LOGBIN_RECORD_MAX * 4 + 3];
+	// Leading delimiter, then the first code byte at `code`.
+	size_t  code = 1;
+	size_t  out  = 2;
+	frame[0] = 0;
+	for (size_t i = 0; i < len; i++) {
+		if (data[i] == 0) {
+			frame[code] = out - code;
+			code = out++;
+		} else {
+			frame[out++] = data[i];
+			if (out - code == 0xff) {
+				frame[code] = 0xff;
+				code = out++;
+			}
+		}
+	}
+	frame[code] = out - code;
+	frame[out++] = 0;
+	console_write(frame, out);
+}
+
+// Whether there are records or a dropped-records count waiting to be sent.
+static inline bool logbin_pending() {
+	return logbin_head != logbin_tail || logbin_lost;
+}
+
+// Take one record out of the buffer and send it if its frame fits in `room` bytes.
+// Returns false if the buffer was empty or the record did not fit.
+static bool logbin_drain_one(size_t room) {
+	uint32_t record[LOGBIN_RECORD_MAX];
+	uint32_t words;
+	
+	bool ie = isr_global_disable();
+	if (logbin_head == logbin_tail) {
+		if (!logbin_lost || room < LOGBIN_FRAME_SIZE(4)) {
+			isr_global_restore(ie);
+			return false;
+		}
+		// Report records lost at the end of a burst without waiting for the next record.
+		record[0] = LOGBIN_LOST_HEADER;
+		record[1] = time_us();
+		record[2] = 0;
+		record[3] = logbin_lost;
+		logbin_lost = 0;
+		isr_global_restore(ie);
+		logbin_send_frame((const uint8_t *) record, 16);
+		return true;
+	}
+	words = (logbin_buf[logbin_tail & (LOGBIN_BUF_WORDS - 1)] >> 16) & 0xff;
+	// Leave the record in the buffer rather than have the console cut its frame short.
+	if (room < LOGBIN_FRAME_SIZE(words)) {
+		isr_global_restore(ie);
+		return false;
+	}
+	for (uint32_t i = 0; i < words; i++) {
+		record[i] = logbin_buf[logbin_tail++ & (LOGBIN_BUF_WORDS - 1)];
+	}
+	isr_global_restore(ie);
+	
+	// RISC-V is little-endian, so the words go out in the order the decoder expects.
+	logbin_send_frame((const uint8_t *) record, words * 4);
+	return true;
+}
+
+static void logbin_drain(void *cookie);
+// Task that drains the buffer to the console.
+static sched_task_t logbin_task = { NULL, logbin_drain, NULL, false };
+
+// Drain task: send records while the console has room for them.
+// When it runs out of room, the console posts the task again once its buffer has emptied.
+static void logbin_drain(void *cookie) {
+	for (int i = 0; i < LOGBIN_DRAIN_BATCH; i++) {
+		if (!logbin_drain_one(console_tx_free())) {
+			if (logbin_pending()) console_tx_notify(&logbin_task);
+			return;
+		}
+	}
+	// Yield to other tasks between batches.
+	sched_post(&logbin_task);
+}
+
+
+
+// Store a binary log record; use the `logkb` macro instead.
+void logkb_write(uint32_t header, const char *msg, ...) {
+	uint32_t now   = time_us();
+	uint32_t words = (header >> 16) & 0xff;
+	uint32_t nargs = (header >> 4) & 15;
+	
+	bool ie = isr_global_disable();
+	bool     was_empty = logbin_head == logbin_tail;
+	uint32_t space     = LOGBIN_BUF_WORDS - (logbin_head - logbin_tail);
+	
+	// Leave room for a dropped-records marker in front of the record.
+	if (space < words + (logbin_lost ? 4 : 0)) {
+		logbin_lost ++;
+		logbin_lost_total ++;
+		isr_global_restore(ie);
+		return;
+	}
+	if (logbin_lost) {
+		logbin_put(LOGBIN_LOST_HEADER);
+		logbin_put(now);
+		logbin_put(0);
+		logbin_put(logbin_lost);
+		logbin_lost = 0;
+	}
+	
+	logbin_put(header);
+	logbin_put(now);
+	logbin_put((uint32_t) msg);
+	va_list args;
+	va_start(args, msg);
+	for (uint32_t i = 0; i < nargs; i++) {
+		if ((header >> (8 + i)) & 1) {
+			uint64_t val = va_arg(args, uint64_t);
+			logbin_put(val);
+			logbin_put(val >> 32);
+		} else {
+			logbin_put(va_arg(args, uint32_t));
+		}
+	}
+	va_end(args);
+	
+	if (was_empty) sched_post(&logbin_task);
+	isr_global_restore(ie);
+}
+
+// Write all pending binary log records to the console now.
+void logkb_flush() {
+	while (logbin_pending()) {
+		if (logbin_drain_one(console_tx_free())) continue;
+		// Make room; give up if the console cannot get rid of its data.
+		console_flush();
+		if (!logbin_drain_one(console_tx_free())) break;
+	}
+}
+
+// Number of binary log records dropped because the buffer was full.
+uint32_t logkb_dropped() {
+	return logbin_lost_total;
+}
@@ -3,9 +3,24 @@
 #include <log.h>
 #include <time.h>
 #include <gpio.h>
+#include <sha.h>
+#include <isr.h>
+#include <sched.h>
+#include <int64.h>
+#include <timer.h>
+#include <console.h>
 
 
 
+// How often to poll the GPIO test input.
+#define BLINK_POLL_US 10000
+
+// Blink GPIO 15 once per second, inverted while GPIO 22 is pulled low.
+static void blink(void *cookie) {
+	int64_t now = time_us();
+	io_write(NULL, 15, int64_udiv1000000(now) & 1 ^ io_read(NULL, 22));
+}
+
 // This is the entrypoint after the stack has been set up and the init functions have been run.
 // Main is not allowed to return, so declare it noreturn.
 void main() __attribute__((noreturn));
@@ -14,6 +29,21 @@ void main() {
 	// Logs always use timestamps and watchdog feeding is currently unimplemented.
 	time_init();
 	
+	// Take over the trap vector so faults are reported and drivers can use interrupts.
+	isr_init();
+	timer_init();
+	console_init();
+	logkf(LOG_DEBUG, "Interrupt entry latency: %u cycles", isr_measure_latency());
+	
+	// Check the SHA-256 implementation against a known answer before trusting it with image checks.
+	static const uint8_t abc_digest[SHA256_DIGEST_LEN] = {
+		0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+	};
+	if (!sha256_verify("abc", 3, abc_digest)) {
+		logk(LOG_ERROR, "SHA-256 self test failed");
+	}
+	
 	// Test a log message.
 	logk(LOG_FATAL, "The ultimage log message test");
 	logk(LOG_ERROR, "The ultimage log message test");
@@ -25,8 +55,10 @@ void main() {
 	io_mode(NULL, 15, IO_MODE_OUTPUT);
 	io_mode(NULL, 22, IO_MODE_INPUT);
 	io_pull(NULL, 22, IO_PULL_UP);
-	while (1) {
-		int64_t now = time_us();
-		io_write(NULL, 15, (now / 1000000) & 1 ^ io_read(NULL, 22));
-	}
+	static ktimer_t blink_timer;
+	timer_setup(&blink_timer, blink, NULL, TIMER_DEFERRED);
+	timer_start(&blink_timer, 0, BLINK_POLL_US);
+	
+	// Hand the CPU over to the scheduler.
+	sched_run();
 }
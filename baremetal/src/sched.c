@@ -0,0 +1,80 @@
+
+#include <sched.h>
+#include <isr.h>
+
+
+
+// Run queue head, oldest task first.
+static sched_task_t  *run_head;
+// Run queue tail.
+static sched_task_t  *run_tail;
+
+
+
+// Initialise a task that will run `fn(cookie)` each time it is posted.
+void sched_task_init(sched_task_t *task, sched_fn_t fn, void *cookie) {
+	task->next   = NULL;
+	task->fn     = fn;
+	task->cookie = cookie;
+	task->queued = false;
+}
+
+// Queue `task` to run once; does nothing if it is already queued.
+// May be called from interrupt handlers.
+void sched_post(sched_task_t *task) {
+	bool ie = isr_global_disable();
+	if (!task->queued) {
+		task->queued = true;
+		task->next   = NULL;
+		if (run_tail) run_tail->next = task;
+		else run_head = task;
+		run_tail = task;
+	}
+	isr_global_restore(ie);
+}
+
+// Take the oldest task from the run queue.
+static sched_task_t *sched_pop() {
+	bool ie = isr_global_disable();
+	sched_task_t *task = run_head;
+	if (task) {
+		run_head = task->next;
+		if (!run_head) run_tail = NULL;
+		task->queued = false;
+	}
+	isr_global_restore(ie);
+	return task;
+}
+
+
+
+// Run all work that is due, returning whether any was done.
+bool sched_run_once() {
+	// Only run what was queued on entry so a task that re-posts itself cannot starve the rest.
+	bool ie = isr_global_disable();
+	sched_task_t *last = run_tail;
+	isr_global_restore(ie);
+	if (!last) return false;
+	
+	sched_task_t *task;
+	do {
+		task = sched_pop();
+		task->fn(task->cookie);
+	} while (task != last);
+	return true;
+}
+
+// Run the scheduler forever, sleeping in WFI when there is nothing to do.
+void sched_run() {
+	while (1) {
+		if (sched_run_once()) continue;
+		
+		// Wait for an interrupt to post work, e.g. a timer expiring.
+		// Interrupts are disabled around the check so a post between it and WFI still wakes the CPU.
+		bool ie = isr_global_disable();
+		if (!run_head) {
+			asm volatile ("wfi");
+		}
+		isr_global_restore(ie);
+	}
+}
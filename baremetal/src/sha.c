@@ -0,0 +1,228 @@
+
+#include <sha.h>
+#include <string.h>
+
+#ifndef SHA_SOFTWARE
+#include <hardware.h>
+#include <clkconfig.h>
+#endif
+
+// Initial SHA-256 hash value.
+static const uint32_t sha256_iv[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+#ifndef SHA_SOFTWARE
+
+// SHA algorithm select (Access: R/W)
+#define SHA_MODE_REG				(SHA_BASE + 0x0000)
+// Block number register, only effective for DMA-SHA (Access: R/W)
+#define SHA_DMA_BLOCK_NUM_REG		(SHA_BASE + 0x000C)
+// Starts the SHA accelerator for Typical SHA operation (Access: WO)
+#define SHA_START_REG				(SHA_BASE + 0x0010)
+// Continues SHA operation (only effective in Typical SHA mode) (Access: WO)
+#define SHA_CONTINUE_REG			(SHA_BASE + 0x0014)
+// Indicates if SHA accelerator is busy or not (Access: RO)
+#define SHA_BUSY_REG				(SHA_BASE + 0x0018)
+// Starts the SHA accelerator for DMA-SHA operation (Access: WO)
+#define SHA_DMA_START_REG			(SHA_BASE + 0x001C)
+// Continues SHA operation (only effective in DMA-SHA mode) (Access: WO)
+#define SHA_DMA_CONTINUE_REG		(SHA_BASE + 0x0020)
+// DMA-SHA interrupt clear register (Access: WO)
+#define SHA_CLEAR_IRQ_REG			(SHA_BASE + 0x0024)
+// DMA-SHA interrupt enable register (Access: R/W)
+#define SHA_IRQ_ENA_REG				(SHA_BASE + 0x0028)
+// Version control register (Access: R/W)
+#define SHA_DATE_REG				(SHA_BASE + 0x002C)
+// Hash value memory, 8 words (Access: R/W)
+#define SHA_H_MEM(N)				(SHA_BASE + 0x0040 + 4 * (N))
+// Message block memory, 16 words (Access: R/W)
+#define SHA_M_MEM(N)				(SHA_BASE + 0x0080 + 4 * (N))
+
+// SHA_MODE_REG value for SHA-256.
+#define SHA_MODE_SHA256				2
+
+// Whether the SHA accelerator clock has been enabled.
+static bool sha_clk_enabled = false;
+
+// Feed `count` consecutive message blocks to the SHA accelerator.
+// The hash value is moved in and out of the accelerator once per call, not once per block.
+// Because the hash value is always restored, even the first block uses CONTINUE instead of START.
+static void sha256_blocks(sha256_ctx_t *ctx, const uint8_t *data, size_t count) {
+	// Restore the intermediate hash value.
+	WRITE_REG(SHA_MODE_REG, SHA_MODE_SHA256);
+	for (int i = 0; i < 8; i++) {
+		WRITE_REG(SHA_H_MEM(i), ctx->h[i]);
+	}
+	
+	for (size_t i = 0; i < count; i++) {
+		// The accelerator takes message words in memory byte order.
+		for (int x = 0; x < 16; x++) {
+			const uint8_t *ptr = data + 4 * x;
+			WRITE_REG(SHA_M_MEM(x), ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t) ptr[3] << 24));
+		}
+		WRITE_REG(SHA_CONTINUE_REG, 1);
+		while (READ_REG(SHA_BUSY_REG));
+		data += SHA256_BLOCK_LEN;
+	}
+	
+	// Save the intermediate hash value.
+	for (int i = 0; i < 8; i++) {
+		ctx->h[i] = READ_REG(SHA_H_MEM(i));
+	}
+}
+
+#else
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+// SHA-256 round constants.
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+// Hash `count` consecutive message blocks on the CPU.
+static void sha256_blocks(sha256_ctx_t *ctx, const uint8_t *data, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		uint32_t w[64];
+		for (int x = 0; x < 16; x++) {
+			const uint8_t *ptr = data + 4 * x;
+			w[x] = ((uint32_t) ptr[0] << 24) | (ptr[1] << 16) | (ptr[2] << 8) | ptr[3];
+		}
+		for (int x = 16; x < 64; x++) {
+			uint32_t s0 = ROTR(w[x-15], 7) ^ ROTR(w[x-15], 18) ^ (w[x-15] >> 3);
+			uint32_t s1 = ROTR(w[x-2], 17) ^ ROTR(w[x-2], 19) ^ (w[x-2] >> 10);
+			w[x] = w[x-16] + s0 + w[x-7] + s1;
+		}
+		
+		uint32_t a = ctx->h[0], b = ctx->h[1], c = ctx->h[2], d = ctx->h[3];
+		uint32_t e = ctx->h[4], f = ctx->h[5], g = ctx->h[6], h = ctx->h[7];
+		for (int x = 0; x < 64; x++) {
+			uint32_t s1 = ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25);
+			uint32_t t1 = h + s1 + ((e & f) ^ (~e & g)) + sha256_k[x] + w[x];
+			uint32_t s0 = ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22);
+			uint32_t t2 = s0 + ((a & b) ^ (a & c) ^ (b & c));
+			h = g; g = f; f = e; e = d + t1;
+			d = c; c = b; b = a; a = t1 + t2;
+		}
+		ctx->h[0] += a; ctx->h[1] += b; ctx->h[2] += c; ctx->h[3] += d;
+		ctx->h[4] += e; ctx->h[5] += f; ctx->h[6] += g; ctx->h[7] += h;
+		
+		data += SHA256_BLOCK_LEN;
+	}
+}
+
+#endif
+
+
+
+// Initialise a SHA-256 hashing state.
+void sha256_init(sha256_ctx_t *ctx) {
+#ifndef SHA_SOFTWARE
+	if (!sha_clk_enabled) {
+		clkconfig_sha(true, true);
+		clkconfig_sha(true, false);
+		sha_clk_enabled = true;
+	}
+	// The accelerator keeps the hash value in digest byte order.
+	for (int i = 0; i < 8; i++) {
+		ctx->h[i] = __builtin_bswap32(sha256_iv[i]);
+	}
+#else
+	for (int i = 0; i < 8; i++) {
+		ctx->h[i] = sha256_iv[i];
+	}
+#endif
+	ctx->buf_len   = 0;
+	ctx->total_len = 0;
+}
+
+// Add `len` bytes of `data` to the hash.
+void sha256_update(sha256_ctx_t *ctx, const void *_data, size_t len) {
+	const uint8_t *data = _data;
+	
+	ctx->total_len += len;
+	
+	// Top up a partial block first.
+	if (ctx->buf_len) {
+		size_t copy = SHA256_BLOCK_LEN - ctx->buf_len;
+		if (copy > len) copy = len;
+		memcpy(ctx->buf + ctx->buf_len, data, copy);
+		ctx->buf_len += copy;
+		data += copy;
+		len  -= copy;
+		if (ctx->buf_len < SHA256_BLOCK_LEN) return;
+		ctx->buf_len = 0;
+		sha256_blocks(ctx, ctx->buf, 1);
+	}
+	
+	// Feed all whole blocks straight from the input.
+	size_t count = len / SHA256_BLOCK_LEN;
+	if (count) {
+		sha256_blocks(ctx, data, count);
+		data += count * SHA256_BLOCK_LEN;
+		len  -= count * SHA256_BLOCK_LEN;
+	}
+	
+	// Keep the remainder for later.
+	memcpy(ctx->buf, data, len);
+	ctx->buf_len = len;
+}
+
+// Finish the hash and write the digest to `out`.
+void sha256_final(sha256_ctx_t *ctx, uint8_t out[SHA256_DIGEST_LEN]) {
+	static const uint8_t pad[SHA256_BLOCK_LEN] = { 0x80 };
+	uint64_t bits = ctx->total_len * 8;
+	
+	// Append the terminator and zeroes up to the length field, which may spill into a second block.
+	sha256_update(ctx, pad, 1 + (SHA256_BLOCK_LEN * 2 - 9 - ctx->buf_len) % SHA256_BLOCK_LEN);
+	uint8_t len_be[8];
+	for (int i = 0; i < 8; i++) {
+		len_be[i] = bits >> (56 - 8 * i);
+	}
+	sha256_update(ctx, len_be, 8);
+	
+#ifndef SHA_SOFTWARE
+	// The accelerator's hash value is already in digest byte order.
+	for (int i = 0; i < 8; i++) {
+		out[4*i+0] = ctx->h[i];
+		out[4*i+1] = ctx->h[i] >> 8;
+		out[4*i+2] = ctx->h[i] >> 16;
+		out[4*i+3] = ctx->h[i] >> 24;
+	}
+#else
+	for (int i = 0; i < 8; i++) {
+		out[4*i+0] = ctx->h[i] >> 24;
+		out[4*i+1] = ctx->h[i] >> 16;
+		out[4*i+2] = ctx->h[i] >> 8;
+		out[4*i+3] = ctx->h[i];
+	}
+#endif
+}
+
+// Hash `len` bytes of `data` in one go.
+void sha256(const void *data, size_t len, uint8_t out[SHA256_DIGEST_LEN]) {
+	sha256_ctx_t ctx;
+	sha256_init(&ctx);
+	sha256_update(&ctx, data, len);
+	sha256_final(&ctx, out);
+}
+
+// Check that `len` bytes of `data` hash to `digest`.
+bool sha256_verify(const void *data, size_t len, const uint8_t digest[SHA256_DIGEST_LEN]) {
+	uint8_t actual[SHA256_DIGEST_LEN];
+	sha256(data, len, actual);
+	uint8_t diff = 0;
+	for (int i = 0; i < SHA256_DIGEST_LEN; i++) {
+		diff |= actual[i] ^ digest[i];
+	}
+	return !diff;
+}
@@ -0,0 +1,73 @@
+
+#include <string.h>
+#include <stdint.h>
+
+// Stop GCC from turning these loops back into calls to themselves.
+#define NO_LIBCALLS __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+// Copy `n` bytes from `src` to `dest`; the regions must not overlap.
+NO_LIBCALLS void *memcpy(void *dest, const void *src, size_t n) {
+	uint8_t       *d = dest;
+	const uint8_t *s = src;
+	
+	// Copy whole words if both pointers share the same alignment.
+	if ((((size_t) d ^ (size_t) s) & 3) == 0) {
+		while (n && ((size_t) d & 3)) {
+			*d++ = *s++;
+			n--;
+		}
+		while (n >= 4) {
+			*(uint32_t *) d = *(const uint32_t *) s;
+			d += 4;
+			s += 4;
+			n -= 4;
+		}
+	}
+	while (n--) {
+		*d++ = *s++;
+	}
+	return dest;
+}
+
+// Copy `n` bytes from `src` to `dest`; the regions may overlap.
+NO_LIBCALLS void *memmove(void *dest, const void *src, size_t n) {
+	uint8_t       *d = dest;
+	const uint8_t *s = src;
+	if (d <= s || d >= s + n) {
+		return memcpy(dest, src, n);
+	}
+	// Overlapping with `dest` after `src`: copy backwards.
+	while (n--) {
+		d[n] = s[n];
+	}
+	return dest;
+}
+
+// Set `n` bytes at `dest` to `c`.
+NO_LIBCALLS void *memset(void *dest, int c, size_t n) {
+	uint8_t *d = dest;
+	while (n && ((size_t) d & 3)) {
+		*d++ = c;
+		n--;
+	}
+	uint32_t word = (uint8_t) c * 0x01010101;
+	while (n >= 4) {
+		*(uint32_t *) d = word;
+		d += 4;
+		n -= 4;
+	}
+	while (n--) {
+		*d++ = c;
+	}
+	return dest;
+}
+
+// Compare `n` bytes of `a` and `b`.
+NO_LIBCALLS int memcmp(const void *a, const void *b, size_t n) {
+	const uint8_t *x = a;
+	const uint8_t *y = b;
+	for (size_t i = 0; i < n; i++) {
+		if (x[i] != y[i]) return x[i] - y[i];
+	}
+	return 0;
+}
@@ -1,5 +1,7 @@
 
 #include <time.h>
+#include <isr.h>
+#include <clkconfig.h>
 
 
 
@@ -75,6 +77,48 @@
 
 
 
+// Timer 0 alarm enable bit in TIMG0_T0CONFIG_REG, cleared by hardware when the alarm fires.
+#define TIMG0_T0_ALARM_EN			(1 << 10)
+// Timer 0 interrupt bit in the TIMG0_INT_*_TIMERS_REG registers.
+#define TIMG0_T0_INT				(1 << 0)
+
+// TIMG0 microseconds to count CPU cycles over during calibration.
+#define TIME_CALIBRATE_US	10000
+
+
+
+// CPU cycle counter ticks per microsecond.
+uint32_t        time_ticks_per_us;
+// Reciprocal of `time_ticks_per_us`, rounded down: (2^32-1) / time_ticks_per_us.
+static uint32_t ticks_recip;
+// Nanoseconds to ticks multiplier in 0.32 fixed point, rounded up.
+static uint32_t ns_recip;
+
+// Reference point: `ref_us` microseconds was at `ref_ticks` cycles.
+static volatile int64_t  ref_us;
+static volatile uint32_t ref_ticks;
+// Incremented around every update of the reference point so readers can detect one.
+static volatile uint32_t ref_seq;
+
+
+
+// Read TIMG0 T0, which counts microseconds; takes a peripheral round trip.
+static int64_t timg0_read() {
+	uint32_t lo = READ_REG(TIMG0_T0LO_REG);
+	int div = 32;
+	WRITE_REG(TIMG0_T0UPDATE_REG, -1);
+	while (READ_REG(TIMG0_T0LO_REG) == lo && --div);
+	return READ_REG(TIMG0_T0LO_REG) | ((uint64_t) READ_REG(TIMG0_T0HI_REG) << 32LLU);
+}
+
+// Exactly divide `ticks` by `time_ticks_per_us`.
+static inline uint32_t ticks_to_us(uint32_t ticks) {
+	// The rounded-down reciprocal is at most one short.
+	uint32_t q = ((uint64_t) ticks * ticks_recip) >> 32;
+	if (ticks - q * time_ticks_per_us >= time_ticks_per_us) q ++;
+	return q;
+}
+
 // Initialise timer and watchdog subsystem.
 void time_init() {
 	// Disable LP WDT.
@@ -87,13 +131,104 @@ void time_init() {
 	WRITE_REG(TIMG0_T0LOADHI_REG, 0);
 	WRITE_REG(TIMG0_T0LOAD_REG, -1);
 	WRITE_REG(TIMG0_T0CONFIG_REG, 0xc0050000);
+	
+	// The cycle counter runs off the CPU clock, which is gated during WFI unless forced on.
+	// sched_run sleeps in WFI whenever it is idle, so without this time would stand still.
+	clkconfig_cpu_waiti(true);
+	
+	// Make the cycle counter count every clock cycle (mpcer = cycles, mpcmr = enable).
+	asm volatile ("csrw 0x7e0, %0" :: "r" (1));
+	asm volatile ("csrw 0x7e1, %0" :: "r" (1));
+	
+	// Calibrate the cycle counter against TIMG0, rounded to whole MHz.
+	int64_t  start_us    = timg0_read();
+	uint32_t start_ticks = time_ticks();
+	int64_t  end_us;
+	do {
+		end_us = timg0_read();
+	} while (end_us - start_us < TIME_CALIBRATE_US);
+	uint32_t ticks = time_ticks() - start_ticks;
+	uint32_t span  = end_us - start_us;
+	time_ticks_per_us = (ticks + span / 2) / span;
+	if (!time_ticks_per_us) time_ticks_per_us = 1;
+	ticks_recip = 0xffffffff / time_ticks_per_us;
+	ns_recip    = (0xffffffff / 1000 + 1) * time_ticks_per_us;
+	
+	ref_ticks = time_ticks();
+	ref_us    = timg0_read();
 }
 
 // Get current time in microseconds.
 int64_t time_us() {
-	uint32_t lo = READ_REG(TIMG0_T0LO_REG);
-	int div = 32;
-	WRITE_REG(TIMG0_T0UPDATE_REG, -1);
-	while (READ_REG(TIMG0_T0LO_REG) == lo && --div);
-	return READ_REG(TIMG0_T0LO_REG) | ((uint64_t) READ_REG(TIMG0_T0HI_REG) << 32LLU);
+	int64_t  base_us;
+	uint32_t base_ticks, delta, seq;
+	do {
+		seq        = ref_seq;
+		base_us    = ref_us;
+		base_ticks = ref_ticks;
+		delta      = time_ticks() - base_ticks;
+	} while (seq != ref_seq);
+	
+	uint32_t us = ticks_to_us(delta);
+	if (delta >= 1LU << 31) {
+		// Move the reference point up by whole microseconds so the counter cannot lap it.
+		bool ie = isr_global_disable();
+		if (ref_ticks == base_ticks) {
+			ref_seq ++;
+			ref_us    = base_us + us;
+			ref_ticks = base_ticks + us * time_ticks_per_us;
+			ref_seq ++;
+		}
+		isr_global_restore(ie);
+	}
+	return base_us + us;
+}
+
+// Busy-wait for `ticks` CPU cycles.
+static void time_delay_ticks(uint32_t ticks) {
+	uint32_t start = time_ticks();
+	while (time_ticks() - start < ticks);
+}
+
+// Busy-wait for at least `us` microseconds.
+void time_delay_us(uint32_t us) {
+	// Split long delays so the tick count cannot overflow.
+	uint32_t chunk = ticks_recip >> 1;
+	while (us > chunk) {
+		time_delay_ticks(chunk * time_ticks_per_us);
+		us -= chunk;
+	}
+	time_delay_ticks(us * time_ticks_per_us);
+}
+
+// Busy-wait for at least `ns` nanoseconds, with a resolution of one CPU cycle.
+void time_delay_ns(uint32_t ns) {
+	time_delay_ticks((((uint64_t) ns * ns_recip) >> 32) + 1);
+}
+
+// Arm the TIMG0 T0 alarm for `deadline` in `time_us` time, returning false if the deadline had already passed.
+// The alarm raises interrupt source ISR_SRC_TG0_T0 until acknowledged with `time_alarm_ack`.
+bool time_alarm_set(int64_t deadline) {
+	// TIMG0 and the cycle counter may drift apart slightly, so convert relative to now.
+	int64_t delta = deadline - time_us();
+	if (delta <= 0) return false;
+	int64_t alarm = timg0_read() + delta;
+	WRITE_REG(TIMG0_T0ALARMLO_REG, alarm);
+	WRITE_REG(TIMG0_T0ALARMHI_REG, alarm >> 32);
+	WRITE_REG(TIMG0_T0CONFIG_REG, READ_REG(TIMG0_T0CONFIG_REG) | TIMG0_T0_ALARM_EN);
+	WRITE_REG(TIMG0_INT_ENA_TIMERS_REG, READ_REG(TIMG0_INT_ENA_TIMERS_REG) | TIMG0_T0_INT);
+	// The alarm only fires when the counter reaches it, so make sure it has not been passed while arming.
+	return timg0_read() < alarm;
+}
+
+// Disarm the TIMG0 T0 alarm.
+void time_alarm_clear() {
+	WRITE_REG(TIMG0_T0CONFIG_REG, READ_REG(TIMG0_T0CONFIG_REG) & ~TIMG0_T0_ALARM_EN);
+	WRITE_REG(TIMG0_INT_ENA_TIMERS_REG, READ_REG(TIMG0_INT_ENA_TIMERS_REG) & ~TIMG0_T0_INT);
+	WRITE_REG(TIMG0_INT_CLR_TIMERS_REG, TIMG0_T0_INT);
+}
+
+// Acknowledge the TIMG0 T0 alarm interrupt.
+void time_alarm_ack() {
+	WRITE_REG(TIMG0_INT_CLR_TIMERS_REG, TIMG0_T0_INT);
 }
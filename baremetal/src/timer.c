@@ -0,0 +1,140 @@
+
+#include <timer.h>
+#include <time.h>
+#include <isr.h>
+
+// Period of the internal timer that keeps `time_us` from losing track of cycle counter wraps.
+#define TIMER_CLOCK_PERIOD_US	1000000
+
+
+
+// Timer queue, earliest deadline first.
+static ktimer_t *timer_head;
+// Internal timer that samples the clock.
+static ktimer_t  clock_timer;
+// Whether `timer_process` is running, i.e. a TIMER_ISR callback may be calling back in.
+static bool      timer_processing;
+
+
+
+// Insert `timer` into the timer queue by deadline, after timers with the same deadline.
+// Must be called with interrupts disabled.
+static void timer_insert(ktimer_t *timer) {
+	ktimer_t **link = &timer_head;
+	while (*link && (*link)->deadline <= timer->deadline) {
+		link = &(*link)->next;
+	}
+	timer->next   = *link;
+	timer->active = true;
+	*link         = timer;
+}
+
+// Remove `timer` from the timer queue if present.
+// Must be called with interrupts disabled.
+static void timer_remove(ktimer_t *timer) {
+	if (!timer->active) return;
+	ktimer_t **link = &timer_head;
+	while (*link != timer) link = &(*link)->next;
+	*link         = timer->next;
+	timer->next   = NULL;
+	timer->active = false;
+}
+
+// Run all expired timers and arm the alarm for the next one.
+// Must be called with interrupts disabled.
+// TIMER_ISR callbacks run from here and may start or stop timers; the queue head is
+// re-read after every callback, so timers they start are picked up by this same loop.
+static void timer_process() {
+	timer_processing = true;
+	while (timer_head) {
+		int64_t now = time_us();
+		while (timer_head && timer_head->deadline <= now) {
+			ktimer_t *timer = timer_head;
+			timer_head    = timer->next;
+			timer->next   = NULL;
+			timer->active = false;
+			if (timer->period) {
+				// Keep the phase, but skip periods that were missed entirely.
+				timer->deadline += timer->period;
+				if (timer->deadline <= now) timer->deadline = now + timer->period;
+				timer_insert(timer);
+			}
+			if (timer->flags & TIMER_ISR) {
+				timer->fn(timer->cookie);
+			} else {
+				sched_post(&timer->task);
+			}
+		}
+		// If the next deadline passed while arming, go around again instead of waiting for the alarm.
+		if (timer_head && time_alarm_set(timer_head->deadline)) {
+			timer_processing = false;
+			return;
+		}
+	}
+	time_alarm_clear();
+	timer_processing = false;
+}
+
+// TIMG0 alarm interrupt handler.
+static void timer_isr(int channel, void *cookie) {
+	time_alarm_ack();
+	timer_process();
+}
+
+// Sample the clock so `time_us` sees every cycle counter wrap even when nothing else reads it.
+static void timer_clock_keepalive(void *cookie) {
+	time_us();
+}
+
+
+
+// Initialise the timer service and connect it to the TIMG0 alarm interrupt.
+// Call after `isr_init`.
+void timer_init() {
+	time_alarm_clear();
+	isr_set_handler(NULL, ISR_CHANNEL_TIMER, timer_isr, NULL);
+	isr_set_priority(NULL, ISR_CHANNEL_TIMER, 1);
+	isr_route(NULL, ISR_SRC_TG0_T0, ISR_CHANNEL_TIMER);
+	isr_enable(NULL, ISR_CHANNEL_TIMER, true);
+	
+	timer_setup(&clock_timer, timer_clock_keepalive, NULL, TIMER_ISR);
+	timer_start(&clock_timer, TIMER_CLOCK_PERIOD_US, TIMER_CLOCK_PERIOD_US);
+}
+
+// Initialise a timer that will run `fn(cookie)` when it expires.
+void timer_setup(ktimer_t *timer, timer_fn_t fn, void *cookie, timer_flags_t flags) {
+	timer->next     = NULL;
+	timer->fn       = fn;
+	timer->cookie   = cookie;
+	timer->deadline = 0;
+	timer->period   = 0;
+	timer->flags    = flags;
+	timer->active   = false;
+	sched_task_init(&timer->task, fn, cookie);
+}
+
+// Start `timer` to expire after `delay` microseconds and then every `period` microseconds if nonzero.
+// Restarts the timer if it was already running. May be called from interrupt handlers.
+void timer_start(ktimer_t *timer, int64_t delay, int64_t period) {
+	timer_start_at(timer, time_us() + delay, period);
+}
+
+// Start `timer` to expire at `deadline` in `time_us` time and then every `period` microseconds if nonzero.
+void timer_start_at(ktimer_t *timer, int64_t deadline, int64_t period) {
+	bool ie = isr_global_disable();
+	timer_remove(timer);
+	timer->deadline = deadline;
+	timer->period   = period;
+	timer_insert(timer);
+	// Re-entering `timer_process` from a TIMER_ISR callback would run timers out of order;
+	// the outer invocation re-arms the alarm when the callback returns.
+	if (timer_head == timer && !timer_processing) timer_process();
+	isr_global_restore(ie);
+}
+
+// Stop `timer` if it is running. A deferred callback that was already posted may still run once.
+void timer_stop(ktimer_t *timer) {
+	bool ie = isr_global_disable();
+	timer_remove(timer);
+	isr_global_restore(ie);
+}
@@ -0,0 +1,197 @@
+
+#include <uart.h>
+#include <hardware.h>
+#include <ringbuf.h>
+#include <isr.h>
+
+// FIFO data register (Access: RO for reads, WO for writes)
+#define UART0_FIFO_REG				(UART0_BASE + 0x0000)
+// Raw interrupt status (Access: R/WTC/SS)
+#define UART0_INT_RAW_REG			(UART0_BASE + 0x0004)
+// Masked interrupt status (Access: RO)
+#define UART0_INT_ST_REG			(UART0_BASE + 0x0008)
+// Interrupt enable bits (Access: R/W)
+#define UART0_INT_ENA_REG			(UART0_BASE + 0x000C)
+// Interrupt clear bits (Access: WT)
+#define UART0_INT_CLR_REG			(UART0_BASE + 0x0010)
+// UART status register (Access: RO)
+#define UART0_STATUS_REG			(UART0_BASE + 0x001C)
+// Configuration register 1 (Access: R/W)
+#define UART0_CONF1_REG				(UART0_BASE + 0x0024)
+// Write to synchronise configuration registers to the UART core clock domain (Access: R/W/SC)
+#define UART0_REG_UPDATE_REG		(UART0_BASE + 0x0098)
+
+// TX FIFO empty interrupt bit, raised while the TX FIFO holds fewer bytes than the threshold.
+#define UART_INT_TXFIFO_EMPTY		(1 << 1)
+// Position of TXFIFO_CNT in UART0_STATUS_REG.
+#define UART_STATUS_TXFIFO_CNT_POS	16
+// Position of TXFIFO_EMPTY_THRHD in UART0_CONF1_REG.
+#define UART_CONF1_TXFIFO_THRHD_POS	8
+
+// Size of the hardware TX FIFO in bytes.
+#define UART_FIFO_SIZE		128
+// Refill the hardware FIFO when it drops below this many bytes.
+#define UART_FIFO_THRESHOLD	32
+// Size of the software TX buffer in bytes; must be a power of two.
+#define UART_TX_BUF_SIZE	1024
+
+
+
+// Software TX buffer.
+static uint8_t       tx_storage[UART_TX_BUF_SIZE];
+static ringbuf_t     tx_buf = { tx_storage, UART_TX_BUF_SIZE, 0, 0 };
+// Whether writes go through `tx_buf`; false during early boot and after a panic.
+static bool          tx_buffered;
+// Transmit statistics.
+static uart_stats_t  tx_stats;
+// Task to post once `tx_buf` is empty.
+static sched_task_t *tx_notify;
+
+
+
+// Number of bytes that fit in the hardware TX FIFO right now.
+static inline uint32_t uart_fifo_space() {
+	uint32_t cnt = (READ_REG(UART0_STATUS_REG) >> UART_STATUS_TXFIFO_CNT_POS) & 0xff;
+	return cnt < UART_FIFO_SIZE ? UART_FIFO_SIZE - cnt : 0;
+}
+
+// Move as much buffered data into the hardware FIFO as fits.
+// Must be called with interrupts disabled.
+static void uart_fill_fifo() {
+	uint32_t space = uart_fifo_space();
+	while (space) {
+		const uint8_t *ptr;
+		uint32_t       len = ringbuf_peek(&tx_buf, &ptr);
+		if (!len) break;
+		if (len > space) len = space;
+		for (uint32_t i = 0; i < len; i++) {
+			WRITE_REG(UART0_FIFO_REG, ptr[i]);
+		}
+		ringbuf_skip(&tx_buf, len);
+		space -= len;
+	}
+	
+	// Only ask for the FIFO empty interrupt while there is something left to send.
+	uint32_t ena = READ_REG(UART0_INT_ENA_REG);
+	if (ringbuf_used(&tx_buf)) {
+		WRITE_REG(UART0_INT_ENA_REG, ena | UART_INT_TXFIFO_EMPTY);
+	} else {
+		WRITE_REG(UART0_INT_ENA_REG, ena & ~UART_INT_TXFIFO_EMPTY);
+		if (tx_notify) {
+			sched_post(tx_notify);
+			tx_notify = NULL;
+		}
+	}
+}
+
+// UART0 interrupt handler.
+static void uart_isr(int channel, void *cookie) {
+	WRITE_REG(UART0_INT_CLR_REG, UART_INT_TXFIFO_EMPTY);
+	uart_fill_fifo();
+}
+
+
+
+// Switch UART0 transmission to the interrupt-driven buffer.
+// Until this is called, writes are synchronous. Call after `isr_init`.
+void uart_init() {
+	// Set the TX FIFO empty threshold.
+	uint32_t conf1 = READ_REG(UART0_CONF1_REG);
+	conf1 &= ~(0xff << UART_CONF1_TXFIFO_THRHD_POS);
+	conf1 |= UART_FIFO_THRESHOLD << UART_CONF1_TXFIFO_THRHD_POS;
+	WRITE_REG(UART0_CONF1_REG, conf1);
+	WRITE_REG(UART0_REG_UPDATE_REG, 1);
+	while (READ_REG(UART0_REG_UPDATE_REG) & 1);
+	
+	WRITE_REG(UART0_INT_ENA_REG, READ_REG(UART0_INT_ENA_REG) & ~UART_INT_TXFIFO_EMPTY);
+	WRITE_REG(UART0_INT_CLR_REG, UART_INT_TXFIFO_EMPTY);
+	isr_set_handler(NULL, ISR_CHANNEL_UART, uart_isr, NULL);
+	isr_set_priority(NULL, ISR_CHANNEL_UART, 1);
+	isr_route(NULL, ISR_SRC_UART0, ISR_CHANNEL_UART);
+	isr_enable(NULL, ISR_CHANNEL_UART, true);
+	
+	tx_buffered = true;
+}
+
+// Queue `len` bytes for transmission on UART0, dropping what does not fit.
+// May be called from interrupt handlers.
+void uart_write(const void *data, size_t len) {
+	if (!tx_buffered) {
+		uart_write_sync(data, len);
+		return;
+	}
+	bool   ie      = isr_global_disable();
+	size_t written = ringbuf_write(&tx_buf, data, len);
+	tx_stats.written += written;
+	tx_stats.dropped += len - written;
+	uint32_t used = ringbuf_used(&tx_buf);
+	if (used > tx_stats.buffered_max) tx_stats.buffered_max = used;
+	uart_fill_fifo();
+	isr_global_restore(ie);
+}
+
+// Queue one byte for transmission on UART0.
+void uart_putc(char c) {
+	uart_write(&c, 1);
+}
+
+// Write `len` bytes to UART0 directly, waiting for space in the hardware FIFO.
+void uart_write_sync(const void *data, size_t len) {
+	const uint8_t *ptr = data;
+	while (len) {
+		uint32_t space = uart_fifo_space();
+		if (space > len) space = len;
+		for (uint32_t i = 0; i < space; i++) {
+			WRITE_REG(UART0_FIFO_REG, ptr[i]);
+		}
+		ptr += space;
+		len -= space;
+	}
+}
+
+// Wait until all buffered data has been handed to the hardware FIFO.
+void uart_flush() {
+	while (ringbuf_used(&tx_buf)) {
+		bool ie = isr_global_disable();
+		uart_fill_fifo();
+		isr_global_restore(ie);
+	}
+}
+
+// Drain the buffer and make all further writes synchronous; for use when the system is going down.
+void uart_panic() {
+	isr_global_disable();
+	tx_buffered = false;
+	WRITE_REG(UART0_INT_ENA_REG, READ_REG(UART0_INT_ENA_REG) & ~UART_INT_TXFIFO_EMPTY);
+	while (ringbuf_used(&tx_buf)) {
+		const uint8_t *ptr;
+		uint32_t       len = ringbuf_peek(&tx_buf, &ptr);
+		uart_write_sync(ptr, len);
+		ringbuf_skip(&tx_buf, len);
+	}
+}
+
+// Number of bytes that can be queued for UART0 without dropping any.
+// Unlimited while writes are synchronous.
+size_t uart_tx_free() {
+	return tx_buffered ? ringbuf_free(&tx_buf) : SIZE_MAX;
+}
+
+// Post `task` once the transmit buffer is empty, or right away if it already is.
+// Only one task can wait at a time; a later call replaces the earlier one.
+void uart_tx_notify(sched_task_t *task) {
+	bool ie = isr_global_disable();
+	if (ringbuf_used(&tx_buf)) {
+		tx_notify = task;
+	} else {
+		sched_post(task);
+	}
+	isr_global_restore(ie);
+}
+
+// Get the transmit statistics.
+void uart_get_stats(uart_stats_t *out) {
+	bool ie = isr_global_disable();
+	*out = tx_stats;
+	isr_global_restore(ie);
+}
@@ -0,0 +1,245 @@
+
+#include <usbjtag.h>
+#include <hardware.h>
+#include <ringbuf.h>
+#include <timer.h>
+#include <time.h>
+#include <isr.h>
+
+// Endpoint 1 data register; each write appends a byte to the IN packet (Access: R/W)
+#define USB_JTAG_EP1_REG			(USB_JTAG_BASE + 0x0000)
+// Endpoint 1 configuration and status register (Access: varies)
+#define USB_JTAG_EP1_CONF_REG		(USB_JTAG_BASE + 0x0004)
+// Raw interrupt status (Access: R/WTC/SS)
+#define USB_JTAG_INT_RAW_REG		(USB_JTAG_BASE + 0x0008)
+// Masked interrupt status (Access: RO)
+#define USB_JTAG_INT_ST_REG			(USB_JTAG_BASE + 0x000C)
+// Interrupt enable bits (Access: R/W)
+#define USB_JTAG_INT_ENA_REG		(USB_JTAG_BASE + 0x0010)
+// Interrupt clear bits (Access: WT)
+#define USB_JTAG_INT_CLR_REG		(USB_JTAG_BASE + 0x0014)
+
+// Write to EP1_CONF to hand the IN packet to the host.
+#define USB_JTAG_EP1_WR_DONE		(1 << 0)
+// Set in EP1_CONF while the IN packet buffer has room.
+#define USB_JTAG_EP1_DATA_FREE		(1 << 1)
+// Interrupt raised when the host has taken the IN packet.
+#define USB_JTAG_INT_IN_EMPTY		(1 << 3)
+
+// Size of a full-speed bulk packet in bytes.
+#define USBJTAG_PACKET_SIZE	64
+// Size of the software TX buffer in bytes; must be a power of two.
+#define USBJTAG_TX_BUF_SIZE	4096
+// How long a partial packet is held back waiting for more data.
+#define USBJTAG_COALESCE_US	1000
+// How long a synchronous write waits for the host before giving up.
+#define USBJTAG_SYNC_TIMEOUT_US	50000
+
+
+
+// Software TX buffer.
+static uint8_t         tx_storage[USBJTAG_TX_BUF_SIZE];
+static ringbuf_t       tx_buf = { tx_storage, USBJTAG_TX_BUF_SIZE, 0, 0 };
+// Whether writes go through `tx_buf`; false during early boot and after a panic.
+static bool            tx_buffered;
+// Whether a packet has been handed to the host and not yet taken.
+static bool            tx_busy;
+// Whether buffered data has waited long enough to be sent in a partial packet.
+static bool            tx_due;
+// Timer that sets `tx_due` once data has waited `USBJTAG_COALESCE_US`.
+static ktimer_t        tx_timer;
+// Set when a synchronous write timed out; no host is reading, so later ones do not wait.
+static bool            tx_nohost;
+// Transmit statistics.
+static usbjtag_stats_t tx_stats;
+// Task to post once `tx_buf` is empty.
+static sched_task_t   *tx_notify;
+
+
+
+// Copy up to one packet from `data` into the IN packet buffer and send it, returning the number of bytes used.
+// Sends nothing and returns 0 if the host has not taken the previous packet yet.
+static uint32_t usbjtag_send_packet(const uint8_t *data, uint32_t len) {
+	uint32_t i;
+	for (i = 0; i < len && i < USBJTAG_PACKET_SIZE; i++) {
+		if (!(READ_REG(USB_JTAG_EP1_CONF_REG) & USB_JTAG_EP1_DATA_FREE)) break;
+		WRITE_REG(USB_JTAG_EP1_REG, data[i]);
+	}
+	if (!i) return 0;
+	WRITE_REG(USB_JTAG_EP1_CONF_REG, USB_JTAG_EP1_WR_DONE);
+	tx_stats.packets ++;
+	return i;
+}
+
+// Send the next packet of buffered data if the host has taken the previous one.
+// Partial packets wait until `tx_due` so that bursts of small writes share a packet.
+// Must be called with interrupts disabled.
+static void usbjtag_pump() {
+	uint32_t used = ringbuf_used(&tx_buf);
+	if (!tx_busy && used && (used >= USBJTAG_PACKET_SIZE || tx_due)) {
+		// Gather a full packet even across the buffer wrap, but only consume what the hardware took;
+		// the rest goes out once the host has read the packet that is still in the way.
+		uint8_t  packet[USBJTAG_PACKET_SIZE];
+		uint32_t len  = ringbuf_copy(&tx_buf, packet, USBJTAG_PACKET_SIZE);
+		uint32_t sent = usbjtag_send_packet(packet, len);
+		ringbuf_skip(&tx_buf, sent);
+		tx_busy = true;
+		used   -= sent;
+	}
+	if (!used) {
+		tx_due = false;
+		if (tx_notify) {
+			sched_post(tx_notify);
+			tx_notify = NULL;
+		}
+	} else if (!tx_due && !tx_timer.active) {
+		timer_start(&tx_timer, USBJTAG_COALESCE_US, 0);
+	}
+	
+	uint32_t ena = READ_REG(USB_JTAG_INT_ENA_REG);
+	if (tx_busy) {
+		WRITE_REG(USB_JTAG_INT_ENA_REG, ena | USB_JTAG_INT_IN_EMPTY);
+	} else {
+		WRITE_REG(USB_JTAG_INT_ENA_REG, ena & ~USB_JTAG_INT_IN_EMPTY);
+	}
+}
+
+// USB Serial/JTAG interrupt handler.
+static void usbjtag_isr(int channel, void *cookie) {
+	if (READ_REG(USB_JTAG_INT_ST_REG) & USB_JTAG_INT_IN_EMPTY) {
+		WRITE_REG(USB_JTAG_INT_CLR_REG, USB_JTAG_INT_IN_EMPTY);
+		tx_busy   = false;
+		tx_nohost = false;
+	}
+	usbjtag_pump();
+}
+
+// Coalescing timeout; let the pending partial packet go.
+static void usbjtag_timeout(void *cookie) {
+	tx_due = true;
+	usbjtag_pump();
+}
+
+// Wait for the IN packet buffer to have room, returning false on timeout.
+static bool usbjtag_wait_free() {
+	if (READ_REG(USB_JTAG_EP1_CONF_REG) & USB_JTAG_EP1_DATA_FREE) {
+		tx_nohost = false;
+		return true;
+	}
+	if (tx_nohost) return false;
+	int64_t deadline = time_us() + USBJTAG_SYNC_TIMEOUT_US;
+	while (!(READ_REG(USB_JTAG_EP1_CONF_REG) & USB_JTAG_EP1_DATA_FREE)) {
+		if (time_us() >= deadline) {
+			tx_nohost = true;
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// Send `len` bytes packet by packet, returning how many were sent before the host stopped reading.
+static size_t usbjtag_send_sync(const uint8_t *data, size_t len) {
+	size_t sent = 0;
+	while (sent < len && usbjtag_wait_free()) {
+		sent += usbjtag_send_packet(data + sent, len - sent);
+	}
+	return sent;
+}
+
+
+
+// Switch USB Serial/JTAG transmission to the interrupt-driven buffer.
+// Until this is called, writes are synchronous. Call after `timer_init`.
+void usbjtag_init() {
+	timer_setup(&tx_timer, usbjtag_timeout, NULL, TIMER_ISR);
+	WRITE_REG(USB_JTAG_INT_ENA_REG, READ_REG(USB_JTAG_INT_ENA_REG) & ~USB_JTAG_INT_IN_EMPTY);
+	WRITE_REG(USB_JTAG_INT_CLR_REG, USB_JTAG_INT_IN_EMPTY);
+	isr_set_handler(NULL, ISR_CHANNEL_USB_JTAG, usbjtag_isr, NULL);
+	isr_set_priority(NULL, ISR_CHANNEL_USB_JTAG, 1);
+	isr_route(NULL, ISR_SRC_USB_SERIAL_JTAG, ISR_CHANNEL_USB_JTAG);
+	isr_enable(NULL, ISR_CHANNEL_USB_JTAG, true);
+	
+	// The last synchronous packet may still be waiting for the host.
+	tx_busy     = !(READ_REG(USB_JTAG_EP1_CONF_REG) & USB_JTAG_EP1_DATA_FREE);
+	tx_due      = false;
+	tx_buffered = true;
+}
+
+// Queue `len` bytes for transmission on the USB serial port, dropping what does not fit.
+// May be called from interrupt handlers.
+void usbjtag_write(const void *data, size_t len) {
+	if (!tx_buffered) {
+		usbjtag_write_sync(data, len);
+		return;
+	}
+	bool   ie      = isr_global_disable();
+	size_t written = ringbuf_write(&tx_buf, data, len);
+	tx_stats.written += written;
+	tx_stats.dropped += len - written;
+	uint32_t used = ringbuf_used(&tx_buf);
+	if (used > tx_stats.buffered_max) tx_stats.buffered_max = used;
+	usbjtag_pump();
+	isr_global_restore(ie);
+}
+
+// Queue one byte for transmission on the USB serial port.
+void usbjtag_putc(char c) {
+	usbjtag_write(&c, 1);
+}
+
+// Write `len` bytes to the USB serial port directly, giving up if the host stops reading.
+void usbjtag_write_sync(const void *data, size_t len) {
+	size_t sent = usbjtag_send_sync(data, len);
+	tx_stats.written += sent;
+	tx_stats.dropped += len - sent;
+}
+
+// Wait until all buffered data has been sent, or the host stops reading.
+void usbjtag_flush() {
+	bool ie = isr_global_disable();
+	tx_due  = true;
+	usbjtag_pump();
+	isr_global_restore(ie);
+	int64_t deadline = time_us() + USBJTAG_SYNC_TIMEOUT_US;
+	while ((ringbuf_used(&tx_buf) || tx_busy) && time_us() < deadline);
+}
+
+// Drain the buffer and make all further writes synchronous; for use when the system is going down.
+void usbjtag_panic() {
+	isr_global_disable();
+	tx_buffered = false;
+	timer_stop(&tx_timer);
+	WRITE_REG(USB_JTAG_INT_ENA_REG, READ_REG(USB_JTAG_INT_ENA_REG) & ~USB_JTAG_INT_IN_EMPTY);
+	while (ringbuf_used(&tx_buf)) {
+		const uint8_t *ptr;
+		uint32_t       len = ringbuf_peek(&tx_buf, &ptr);
+		tx_stats.dropped += len - usbjtag_send_sync(ptr, len);
+		ringbuf_skip(&tx_buf, len);
+	}
+}
+
+// Number of bytes that can be queued for the USB serial port without dropping any.
+// Unlimited while writes are synchronous.
+size_t usbjtag_tx_free() {
+	return tx_buffered ? ringbuf_free(&tx_buf) : SIZE_MAX;
+}
+
+// Post `task` once the transmit buffer is empty, or right away if it already is.
+// Only one task can wait at a time; a later call replaces the earlier one.
+void usbjtag_tx_notify(sched_task_t *task) {
+	bool ie = isr_global_disable();
+	if (ringbuf_used(&tx_buf)) {
+		tx_notify = task;
+	} else {
+		sched_post(task);
+	}
+	isr_global_restore(ie);
+}
+
+// Get the transmit statistics.
+void usbjtag_get_stats(usbjtag_stats_t *out) {
+	bool ie = isr_global_disable();
+	*out = tx_stats;
+	isr_global_restore(ie);
+}
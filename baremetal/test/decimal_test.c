@@ -0,0 +1,238 @@
+
+// Host test and benchmark for decimal.c.
+// Checks decimal_u32 and decimal_u64 against printf and against the double dabble
+// conversion that rawprintudec used before, then times both.
+// Build and run with `make test` or `make bench`; `make test-full` also checks every 32-bit value.
+
+#include <decimal.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Number of random values compared against the reference conversions.
+#define RANDOM_COUNT	20000000
+// Number of values converted per benchmark run.
+#define BENCH_COUNT		2000000
+
+
+
+// 16-bit double dabble, as formerly in rawprint.c.
+static void double_dabble_16(uint16_t val, char outbuf[5]) {
+	// Shift in first 3 bits.
+	uint32_t buf = val >> 13;
+	val <<= 3;
+	
+	// Perform double dabble on the remaining 13 bits.
+	for (int i = 0; i < 13; i++) {
+		uint32_t mask = ((buf | (buf >> 1)) & (buf >> 2)) | (buf >> 3);
+		buf += (mask & 0x11111) * 3;
+		buf <<= 1;
+		buf |= val >> 15;
+		val <<= 1;
+	}
+	
+	// Output the ASCII values.
+	for (int i = 0; i < 5; i++) {
+		outbuf[4 - i] = '0' + ((buf >> (4*i)) & 15);
+	}
+}
+
+// 32-bit double dabble, as formerly in rawprint.c.
+static void double_dabble_32(uint32_t val, char outbuf[10]) {
+	// Shift in first 3 bits.
+	uint64_t buf = val >> 29;
+	val <<= 3;
+	
+	// Perform double dabble on the remaining 29 bits.
+	for (int i = 0; i < 29; i++) {
+		uint64_t mask = ((buf | (buf >> 1)) & (buf >> 2)) | (buf >> 3);
+		buf += (mask & 0x1111111111) * 3;
+		buf <<= 1;
+		buf |= val >> 31;
+		val <<= 1;
+	}
+	
+	// Output the ASCII values.
+	for (int i = 0; i < 10; i++) {
+		outbuf[9 - i] = '0' + ((buf >> (4*i)) & 15);
+	}
+}
+
+// 64-bit double dabble, as formerly in rawprint.c.
+static void double_dabble_64(uint64_t val, char outbuf[20]) {
+	// Shift in first 3 bits.
+	uint64_t buf_lo = val >> 61;
+	uint16_t buf_hi = 0;
+	val <<= 3;
+	
+	// Perform double dabble on the remaining 61 bits.
+	for (int i = 0; i < 61; i++) {
+		// Increment the digits.
+		uint64_t mask = ((buf_lo | (buf_lo >> 1)) & (buf_lo >> 2)) | (buf_lo >> 3);
+		buf_lo += (mask & 0x1111111111111111) * 3;
+		mask = ((buf_hi | (buf_hi >> 1)) & (buf_hi >> 2)) | (buf_hi >> 3);
+		buf_hi += (mask & 0x1111) * 3;
+		
+		// Shift the bits.
+		buf_hi <<= 1;
+		buf_hi |= buf_lo >> 63;
+		buf_lo <<= 1;
+		buf_lo |= val >> 63;
+		val    <<= 1;
+	}
+	
+	// Output the ASCII values.
+	for (int i = 0; i < 16; i++) {
+		outbuf[19 - i] = '0' + ((buf_lo >> (4*i)) & 15);
+	}
+	for (int i = 0; i < 4; i++) {
+		outbuf[3 - i] = '0' + ((buf_hi >> (4*i)) & 15);
+	}
+}
+
+
+
+// Convert `val` the way the old rawprintudec did: smallest double dabble, leading zeroes stripped.
+static size_t old_decimal(uint64_t val, char out[DECIMAL_MAX_DIGITS + 1]) {
+	char   buf[20];
+	size_t digits;
+	if (val <= UINT16_MAX) {
+		double_dabble_16(val, buf);
+		digits = 5;
+	} else if (val <= UINT32_MAX) {
+		double_dabble_32(val, buf);
+		digits = 10;
+	} else {
+		double_dabble_64(val, buf);
+		digits = 20;
+	}
+	size_t skip = 0;
+	while (skip + 1 < digits && buf[skip] == '0') skip ++;
+	memcpy(out, buf + skip, digits - skip);
+	out[digits - skip] = 0;
+	return digits - skip;
+}
+
+// Convert `val` with decimal_u64 into a NUL-terminated string.
+static size_t new_decimal(uint64_t val, char out[DECIMAL_MAX_DIGITS + 1]) {
+	char   buf[DECIMAL_MAX_DIGITS];
+	char  *ptr = decimal_u64(val, buf + DECIMAL_MAX_DIGITS);
+	size_t len = buf + DECIMAL_MAX_DIGITS - ptr;
+	memcpy(out, ptr, len);
+	out[len] = 0;
+	return len;
+}
+
+// Random 64-bit value with a random magnitude, so that every digit count gets covered.
+static uint64_t random_value() {
+	uint64_t val = ((uint64_t) rand() << 42) ^ ((uint64_t) rand() << 21) ^ rand();
+	return val >> (rand() % 64);
+}
+
+// Compare both conversions and printf for `val`, returning false on a mismatch.
+static bool check(uint64_t val) {
+	char expect[32], old_out[32], new_out[32];
+	snprintf(expect, sizeof(expect), "%llu", (unsigned long long) val);
+	old_decimal(val, old_out);
+	new_decimal(val, new_out);
+	if (strcmp(expect, new_out) || strcmp(expect, old_out)) {
+		printf("FAIL %s: decimal_u64 %s, double dabble %s\n", expect, new_out, old_out);
+		return false;
+	}
+	if (val <= UINT32_MAX) {
+		char  buf[10];
+		char *ptr = decimal_u32(val, buf + 10);
+		if ((size_t) (buf + 10 - ptr) != strlen(expect) || memcmp(ptr, expect, buf + 10 - ptr)) {
+			printf("FAIL %s: decimal_u32 %.*s\n", expect, (int) (buf + 10 - ptr), ptr);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Check values around every power of ten and the edges of the 16-, 32- and 64-bit ranges.
+static bool test_edges() {
+	uint64_t pow10 = 1;
+	for (int i = 0; i < 20; i++) {
+		for (int delta = -2; delta <= 2; delta++) {
+			if (!check(pow10 + delta)) return false;
+		}
+		pow10 *= 10;
+	}
+	static const uint64_t edges[] = {
+		0, UINT16_MAX, UINT16_MAX + 1ull, UINT32_MAX, UINT32_MAX + 1ull,
+		100000000ull * 100000000ull - 1, 100000000ull * 100000000ull, UINT64_MAX - 1, UINT64_MAX,
+	};
+	for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+		if (!check(edges[i])) return false;
+	}
+	return true;
+}
+
+// Check random values.
+static bool test_random() {
+	for (long i = 0; i < RANDOM_COUNT; i++) {
+		if (!check(random_value())) return false;
+	}
+	return true;
+}
+
+// Check decimal_u32 against printf for every 32-bit value; takes several minutes.
+static bool test_exhaustive() {
+	for (uint64_t val = 0; val <= UINT32_MAX; val++) {
+		char  expect[16];
+		char  buf[10];
+		char *ptr = decimal_u32(val, buf + 10);
+		int   len = snprintf(expect, sizeof(expect), "%u", (unsigned) val);
+		if (buf + 10 - ptr != len || memcmp(ptr, expect, len)) {
+			printf("FAIL %s: decimal_u32 %.*s\n", expect, (int) (buf + 10 - ptr), ptr);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Time `convert` over `vals` in nanoseconds per value.
+static double bench(size_t (*convert)(uint64_t, char *), const uint64_t *vals, size_t count) {
+	char            out[DECIMAL_MAX_DIGITS + 1];
+	volatile size_t sink = 0;
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (size_t i = 0; i < count; i++) {
+		sink += convert(vals[i], out);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	(void) sink;
+	return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / count;
+}
+
+// Benchmark the old and new conversions over values of every magnitude, then over 32-bit values only.
+static void run_bench() {
+	static uint64_t vals[BENCH_COUNT];
+	for (size_t i = 0; i < BENCH_COUNT; i++) vals[i] = random_value();
+	printf("64-bit mix:  double dabble %6.1f ns, decimal_u64 %6.1f ns\n",
+		bench(old_decimal, vals, BENCH_COUNT), bench(new_decimal, vals, BENCH_COUNT));
+	for (size_t i = 0; i < BENCH_COUNT; i++) vals[i] = (uint32_t) random_value();
+	printf("32-bit only: double dabble %6.1f ns, decimal_u64 %6.1f ns\n",
+		bench(old_decimal, vals, BENCH_COUNT), bench(new_decimal, vals, BENCH_COUNT));
+}
+
+
+
+int main(int argc, char **argv) {
+	bool full     = argc > 1 && !strcmp(argv[1], "full");
+	bool do_bench = argc > 1 && !strcmp(argv[1], "bench");
+	srand(1);
+	
+	if (do_bench) {
+		run_bench();
+		return 0;
+	}
+	if (!test_edges() || !test_random()) return 1;
+	if (full && !test_exhaustive()) return 1;
+	printf("decimal: OK\n");
+	return 0;
+}
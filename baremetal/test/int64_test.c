@@ -0,0 +1,192 @@
+
+// Host test and benchmark for the 64-bit division runtime in int64.c and the constant helpers in int64.h.
+// int64.c is built with its symbols renamed to test_* (see the Makefile) so it does not replace the host's own,
+// and every result is compared against native division.
+// Build and run with `make test` or `make bench`.
+
+#include <int64.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Number of random operand pairs compared against native division.
+#define RANDOM_COUNT	50000000
+// Number of divisions per benchmark run.
+#define BENCH_COUNT		1000000
+
+uint64_t test_udivdi3(uint64_t a, uint64_t b);
+uint64_t test_umoddi3(uint64_t a, uint64_t b);
+int64_t  test_divdi3 (int64_t  a, int64_t  b);
+int64_t  test_moddi3 (int64_t  a, int64_t  b);
+
+// Number of mismatches found.
+static long failures;
+
+
+
+// C port of the shift-subtract division that int64.S used, without its one-entry result cache.
+static uint64_t old_udivdi3(uint64_t a, uint64_t b) {
+	if (!(a >> 32) && !(b >> 32)) return (uint32_t) a / (uint32_t) b;
+	
+	// Shift the divisor all the way up, then subtract it back down one bit at a time.
+	int n = 0;
+	while (!(b >> 63)) {
+		b <<= 1;
+		n ++;
+	}
+	uint64_t q = 0;
+	for (; n >= 0; n--) {
+		if (a >= b) {
+			a -= b;
+			q |= 1ull << n;
+		}
+		b >>= 1;
+	}
+	return q;
+}
+
+// Random 64-bit value with a random magnitude, so that every fast path gets covered.
+static uint64_t random_value() {
+	uint64_t val = ((uint64_t) rand() << 42) ^ ((uint64_t) rand() << 21) ^ rand();
+	return val >> (rand() % 64);
+}
+
+// Report a mismatch, printing only the first few.
+static void fail(const char *what, uint64_t a, uint64_t b) {
+	if (failures++ < 10) {
+		printf("FAIL %s 0x%016llx 0x%016llx\n", what, (unsigned long long) a, (unsigned long long) b);
+	}
+}
+
+// Check all four runtime functions on one operand pair.
+static void check(uint64_t a, uint64_t b) {
+	if (!b) {
+		// RISC-V convention: all ones quotient, dividend as remainder.
+		if (test_udivdi3(a, 0) != UINT64_MAX) fail("udiv by 0", a, b);
+		if (test_umoddi3(a, 0) != a) fail("umod by 0", a, b);
+		if (test_divdi3(a, 0) != -1) fail("div by 0", a, b);
+		if (test_moddi3(a, 0) != (int64_t) a) fail("mod by 0", a, b);
+		return;
+	}
+	if (test_udivdi3(a, b) != a / b) fail("udiv", a, b);
+	if (test_umoddi3(a, b) != a % b) fail("umod", a, b);
+	
+	// Every sign combination; INT64_MIN / -1 overflows natively and is skipped.
+	for (int signs = 0; signs < 4; signs++) {
+		int64_t sa = (int64_t) (signs & 1 ? -a : a);
+		int64_t sb = (int64_t) (signs & 2 ? -b : b);
+		if (sa == INT64_MIN && sb == -1) continue;
+		if (test_divdi3(sa, sb) != sa / sb) fail("div", sa, sb);
+		if (test_moddi3(sa, sb) != sa % sb) fail("mod", sa, sb);
+	}
+}
+
+// Check every pair of interesting edge values.
+static void test_edges() {
+	static const uint64_t edges[] = {
+		0, 1, 2, 3, 7, 10, 1000, 1000000, 100000000,
+		0x7fffffff, 0x80000000, 0xfffffffe, 0xffffffff,
+		0x100000000, 0x100000001, 0x1ffffffff, 0xffff0000, 0xffffffff00000000,
+		0x7fffffffffffffff, 0x8000000000000000, 0x8000000000000001, 0xfffffffffffffffe, 0xffffffffffffffff,
+	};
+	size_t count = sizeof(edges) / sizeof(edges[0]);
+	for (size_t i = 0; i < count; i++) {
+		for (size_t j = 0; j < count; j++) {
+			check(edges[i], edges[j]);
+		}
+	}
+}
+
+// Check random operand pairs.
+static void test_random() {
+	for (long i = 0; i < RANDOM_COUNT; i++) {
+		check(random_value(), random_value());
+	}
+}
+
+// Check the constant-divisor helpers, including the values just below 2^64.
+static void test_constants() {
+	for (long i = 0; i < RANDOM_COUNT / 4; i++) {
+		uint64_t val = i < 1000 ? UINT64_MAX - i : random_value();
+		if (int64_udiv10(val)        != val / 10)        fail("udiv10", val, 10);
+		if (int64_udiv1000(val)      != val / 1000)      fail("udiv1000", val, 1000);
+		if (int64_udiv1000000(val)   != val / 1000000)   fail("udiv1000000", val, 1000000);
+		if (int64_udiv100000000(val) != val / 100000000) fail("udiv100000000", val, 100000000);
+	}
+}
+
+
+
+// Current time in CPU cycles where the host has a cycle counter, otherwise in nanoseconds.
+static inline uint64_t bench_clock() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ull + now.tv_nsec;
+#endif
+}
+
+// Time `divide` over the operand arrays, per division.
+static double bench(uint64_t (*divide)(uint64_t, uint64_t), const uint64_t *a, const uint64_t *b) {
+	volatile uint64_t sink  = 0;
+	uint64_t          start = bench_clock();
+	for (size_t i = 0; i < BENCH_COUNT; i++) {
+		sink += divide(a[i], b[i]);
+	}
+	(void) sink;
+	return (double) (bench_clock() - start) / BENCH_COUNT;
+}
+
+// Divide by 1000 through the constant helper, with the runtime's signature.
+static uint64_t helper_udiv1000(uint64_t a, uint64_t b) {
+	(void) b;
+	return int64_udiv1000(a);
+}
+
+// Benchmark the old and new runtimes on random operands and on a constant divisor.
+static void run_bench() {
+	static uint64_t a[BENCH_COUNT], b[BENCH_COUNT], thousand[BENCH_COUNT];
+	for (size_t i = 0; i < BENCH_COUNT; i++) {
+		a[i]        = random_value();
+		b[i]        = random_value() | 1;
+		thousand[i] = 1000;
+	}
+#if defined(__x86_64__) || defined(__i386__)
+	const char *unit = "cycles";
+#else
+	const char *unit = "ns";
+#endif
+	printf("random:    shift-subtract %7.1f %s, __udivdi3 %7.1f %s\n",
+		bench(old_udivdi3, a, b), unit, bench(test_udivdi3, a, b), unit);
+	printf("by 1000:   shift-subtract %7.1f %s, __udivdi3 %7.1f %s, int64_udiv1000 %7.1f %s\n",
+		bench(old_udivdi3, a, thousand), unit, bench(test_udivdi3, a, thousand), unit,
+		bench(helper_udiv1000, a, thousand), unit);
+}
+
+
+
+int main(int argc, char **argv) {
+	srand(1);
+	
+	if (argc > 1 && !strcmp(argv[1], "bench")) {
+		run_bench();
+		return 0;
+	}
+	test_edges();
+	test_random();
+	test_constants();
+	if (failures) {
+		printf("int64: %ld failures\n", failures);
+		return 1;
+	}
+	printf("int64: OK\n");
+	return 0;
+}
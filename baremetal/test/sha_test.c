@@ -0,0 +1,140 @@
+
+// Host test for the SHA_SOFTWARE path of sha.c.
+// Checks the FIPS 180-2 vectors, inputs on either side of the padding block boundary,
+// and that feeding the same input in pieces gives the same digest as hashing it in one go.
+// Build and run with `make test`.
+
+#include <sha.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Number of bytes in the million-'a' vector.
+#define MILLION_LEN		1000000
+// Longest input used for the piecewise check.
+#define CHUNKED_MAX_LEN	200
+
+// Number of mismatches found.
+static long failures;
+
+
+
+// Format `digest` as lowercase hex into `out`.
+static void to_hex(const uint8_t digest[SHA256_DIGEST_LEN], char out[2 * SHA256_DIGEST_LEN + 1]) {
+	for (int i = 0; i < SHA256_DIGEST_LEN; i++) {
+		snprintf(out + 2 * i, 3, "%02x", digest[i]);
+	}
+}
+
+// Compare `digest` against the hex string `expect`, reporting a mismatch as `what`.
+static void check(const char *what, const uint8_t digest[SHA256_DIGEST_LEN], const char *expect) {
+	char hex[2 * SHA256_DIGEST_LEN + 1];
+	to_hex(digest, hex);
+	if (strcmp(hex, expect)) {
+		printf("FAIL %s: got %s, expected %s\n", what, hex, expect);
+		failures ++;
+	}
+}
+
+// Fill `buf` with a pattern that differs from byte to byte.
+static void pattern(uint8_t *buf, size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		buf[i] = i * 7 + 3;
+	}
+}
+
+
+
+// Check the FIPS 180-2 test vectors, and sha256_verify on one of them.
+static void test_vectors() {
+	uint8_t digest[SHA256_DIGEST_LEN];
+	
+	sha256("", 0, digest);
+	check("empty", digest, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	
+	sha256("abc", 3, digest);
+	check("abc", digest, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+	if (!sha256_verify("abc", 3, digest) || sha256_verify("abd", 3, digest)) {
+		printf("FAIL sha256_verify\n");
+		failures ++;
+	}
+	
+	const char *msg448 = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	sha256(msg448, strlen(msg448), digest);
+	check("448-bit", digest, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+	
+	// Fed in odd-sized pieces so that most updates start on a partial block.
+	sha256_ctx_t ctx;
+	uint8_t      piece[1000];
+	memset(piece, 'a', sizeof(piece));
+	sha256_init(&ctx);
+	for (size_t done = 0; done < MILLION_LEN;) {
+		size_t len = MILLION_LEN - done < 999 ? MILLION_LEN - done : 999;
+		sha256_update(&ctx, piece, len);
+		done += len;
+	}
+	sha256_final(&ctx, digest);
+	check("million a", digest, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+// Check inputs whose padding just fits in, or just spills out of, the last block.
+static void test_padding() {
+	static const struct {
+		size_t      len;
+		const char *digest;
+	} vectors[] = {
+		{ 55,  "e7313d333c272e639f790978283f9eb392e843d0f29b7016828bb1daa4aac70b" },
+		{ 56,  "4324d65f3c103567f5589c710bc08f8523f929a9272e3af36fc968e52abc6c27" },
+		{ 63,  "81c80242132f230c3bd41b3e63bbcff16107339549214a99614ff26664625055" },
+		{ 64,  "39e3d7b6b5d075d37d053ad89b24b41bef4f3c29760c84447cab3f3be1882241" },
+		{ 65,  "aacca6ff74fdbb296d165a45cecfa04e5127bc008770fbbdd48006f2d2fae95e" },
+		{ 119, "9ce7368e4daf32341631b492e80359dc9f594b48453cd0dd5bf0b19279cc177e" },
+		{ 120, "7836b787757e95e58b3ca5aec90b1b004e8deba1e50e9675af9cabf1a13a04b5" },
+	};
+	uint8_t buf[128];
+	pattern(buf, sizeof(buf));
+	for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+		uint8_t digest[SHA256_DIGEST_LEN];
+		char    what[32];
+		sha256(buf, vectors[i].len, digest);
+		snprintf(what, sizeof(what), "%zu bytes", vectors[i].len);
+		check(what, digest, vectors[i].digest);
+	}
+}
+
+// Check that every split of every input up to CHUNKED_MAX_LEN bytes hashes the same as the whole.
+static void test_chunked() {
+	uint8_t buf[CHUNKED_MAX_LEN];
+	pattern(buf, sizeof(buf));
+	for (size_t len = 0; len <= CHUNKED_MAX_LEN; len++) {
+		uint8_t expect[SHA256_DIGEST_LEN];
+		sha256(buf, len, expect);
+		for (size_t split = 0; split <= len; split++) {
+			sha256_ctx_t ctx;
+			uint8_t      digest[SHA256_DIGEST_LEN];
+			sha256_init(&ctx);
+			sha256_update(&ctx, buf, split);
+			sha256_update(&ctx, buf + split, len - split);
+			sha256_final(&ctx, digest);
+			if (memcmp(digest, expect, SHA256_DIGEST_LEN)) {
+				if (failures++ < 10) printf("FAIL %zu bytes split at %zu\n", len, split);
+			}
+		}
+	}
+}
+
+
+
+int main() {
+	test_vectors();
+	test_padding();
+	test_chunked();
+	if (failures) {
+		printf("sha: %ld failures\n", failures);
+		return 1;
+	}
+	printf("sha: OK\n");
+	return 0;
+}
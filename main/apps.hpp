@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Resource usage of an app as seen by the runtime.
+// Of the ABI calls only display_write is counted; delay_ms, uptime_ms and io_* are handled
+// inside badgeabi and are not attributed per app.
+struct app_stats {
+	// CPU time used by the app's task in microseconds; wraps after about 71 minutes.
+	uint32_t cpu_us;
+	// Lowest amount of stack that was ever free, in bytes.
+	uint32_t stack_free_min;
+	// Number of display_write calls.
+	uint32_t disp_calls;
+	// Total time spent in display_write in microseconds.
+	uint64_t disp_us;
+	// Heap currently allocated by the app's task in bytes; needs CONFIG_HEAP_TASK_TRACKING, 0 otherwise.
+	// Frozen at its last value once the app exits.
+	uint32_t heap_used;
+	// Highest `heap_used` seen by `app_get_stats`; allocation peaks between two calls are missed.
+	uint32_t heap_peak;
+	// Number of times the slot has been started, 0 if it never was.
+	// The other fields are reset each time this changes.
+	uint32_t starts;
+};
+
+// Number of app slots.
+size_t app_count();
+// Name of the app in slot `index`, or nullptr if out of range.
+const char *app_name(size_t index);
+// Slot index of the app called `name`, or -1 if there is none.
+int app_find(const char *name);
+// Whether the app in slot `index` is running.
+bool app_running(size_t index);
+// Get a copy of the resource usage of the app in slot `index`; kept after the app exits.
+// Returns false if `index` is out of range.
+bool app_get_stats(size_t index, app_stats *out);
+// Give display focus to the app in slot `index`.
+// Returns false if `index` is out of range or the app is not running.
+bool app_focus(size_t index);
+// Start an app received by the upload server in the upload slot and give it display focus.
+// Returns false if the previous uploaded app is still running.
+bool app_start_uploaded(const char *name, const void *elf, size_t elf_len);
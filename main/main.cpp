@@ -3,37 +3,310 @@
 #include <string.h>
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#ifdef CONFIG_HEAP_TASK_TRACKING
+#include <esp_heap_task_info.h>
+#endif
 static const char *TAG = "main";
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
 #include <badgert.h>
 #include <badgeabi.h>
 
 #include <managed_i2c.h>
 #include <driver_ssd1306.h>
 
+#include "upload.hpp"
+#include "apps.hpp"
+
 #include <mpu.hpp>
 #include <kernel.hpp>
 
-// extern const char elf_start[] asm("_binary_main7_o_start");
-// extern const char elf_end[] asm("_binary_main7_o_end");
+extern const char elf6_start[] asm("_binary_main6_o_start");
+extern const char elf6_end[] asm("_binary_main6_o_end");
 
-extern const char elf_start[] asm("_binary_main6_o_start");
-extern const char elf_end[] asm("_binary_main6_o_end");
+extern const char elf7_start[] asm("_binary_main7_o_start");
+extern const char elf7_end[] asm("_binary_main7_o_end");
 
 extern const char elflib_start[] asm("_binary_libpax_so_start");
 extern const char elflib_end[] asm("_binary_libpax_so_end");
 
+// An app embedded into the firmware, run as its own FreeRTOS task.
+struct embedded_app {
+	// Name passed to the loader.
+	const char  *name;
+	// Start of the embedded ELF file.
+	const char  *elf_start;
+	// End of the embedded ELF file.
+	const char  *elf_end;
+	// FreeRTOS priority of the app's task.
+	UBaseType_t  priority;
+	// Stack size of the app's task in bytes.
+	uint32_t     stack_size;
+	// Task running the app, nullptr when not running.
+	TaskHandle_t task;
+	// Resource usage, kept after the app exits.
+	app_stats    stats;
+};
+
+// Apps started at boot; the first one starts out with display focus.
+static embedded_app apps[] = {
+	// Graphics demo, foreground.
+	{ "main6.o", elf6_start, elf6_end, 3, 4096, nullptr },
+	// Console printer, background.
+	{ "main7.o", elf7_start, elf7_end, 2, 4096, nullptr },
+	// Slot for apps received by the upload server, not started at boot.
+	{ "upload",  nullptr,    nullptr,  3, 4096, nullptr },
+};
+// Index of the upload slot in `apps`.
+#define APP_UPLOAD_SLOT (APP_COUNT - 1)
+#define APP_COUNT (sizeof(apps) / sizeof(embedded_app))
+
+// Interval between telemetry log summaries.
+#define TELEMETRY_INTERVAL_MS 10000
+
+// Task whose display writes reach the display; other apps' writes are dropped.
+static TaskHandle_t      focus_task;
+// Serialises access to the display between apps.
+static SemaphoreHandle_t disp_mutex;
+
 uint8_t framebuffer[128*64/8];
 
+// Find the app running on the current task, if any.
+static embedded_app *app_current() {
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+	for (size_t i = 0; i < APP_COUNT; i++) {
+		if (apps[i].task == self) return &apps[i];
+	}
+	return nullptr;
+}
+
 bool flush_my_disp(const void *buf, size_t buf_len, int x, int y, int width, int height, void *cookie) {
-	// if (x == 0 && y == 0 && width == 128 && height == 64) {
-		driver_ssd1306_write((const uint8_t *) buf);
-	// } else {
-	// 	return !driver_ssd1306_write_part((const uint8_t *) buf, x, y, x+width-1, y+height-1);
-	// }
+	int64_t start = esp_timer_get_time();
+	xSemaphoreTake(disp_mutex, portMAX_DELAY);
+	// Only the app with focus gets to draw.
+	if (xTaskGetCurrentTaskHandle() == focus_task) {
+		// if (x == 0 && y == 0 && width == 128 && height == 64) {
+			driver_ssd1306_write((const uint8_t *) buf);
+		// } else {
+		// 	return !driver_ssd1306_write_part((const uint8_t *) buf, x, y, x+width-1, y+height-1);
+		// }
+	}
+	xSemaphoreGive(disp_mutex);
+	
+	// Account the call to the app that made it, in the same suspend section `app_get_stats` copies under.
+	embedded_app *app = app_current();
+	if (app) {
+		int64_t took = esp_timer_get_time() - start;
+		vTaskSuspendAll();
+		app->stats.disp_calls ++;
+		app->stats.disp_us += took;
+		xTaskResumeAll();
+	}
 	return false;
 }
 
+// Bytes of heap currently allocated by `task`.
+// Walks every heap block, so it is too slow for anything but periodic statistics.
+static uint32_t app_heap_used(TaskHandle_t task) {
+#ifdef CONFIG_HEAP_TASK_TRACKING
+	// Only a handful of tasks run; blocks of tasks beyond `totals` are not counted.
+	heap_task_totals_t      totals[16] = {};
+	size_t                  num_totals = 0;
+	size_t                  num_blocks = 0;
+	heap_task_info_params_t params     = {};
+	params.num_blocks = &num_blocks;
+	params.totals     = totals;
+	params.num_totals = &num_totals;
+	params.max_totals = sizeof(totals) / sizeof(totals[0]);
+	heap_caps_get_per_task_info(&params);
+	
+	// Caps and mask 0 in slot 0 match every block.
+	for (size_t i = 0; i < num_totals; i++) {
+		if (totals[i].task == task) return totals[i].size[0];
+	}
+#endif
+	return 0;
+}
+
+// Refresh the task-derived part of an app's statistics.
+// Does nothing if the app is not running.
+static void app_update_stats(embedded_app *app) {
+	// Keep the app's task from exiting and being deleted while it is inspected.
+	vTaskSuspendAll();
+	TaskHandle_t task = app->task;
+	if (task) {
+		TaskStatus_t status;
+		vTaskGetInfo(task, &status, pdTRUE, eInvalid);
+		app->stats.cpu_us         = status.ulRunTimeCounter;
+		app->stats.stack_free_min = status.usStackHighWaterMark;
+	}
+	xTaskResumeAll();
+	if (!task) return;
+	
+	// The heap walk takes the heap locks, so it runs with the scheduler going again.
+	// It only compares block owners against the handle, which is fine even if the task exited meanwhile.
+	uint32_t heap = app_heap_used(task);
+	vTaskSuspendAll();
+	if (app->task == task) {
+		app->stats.heap_used = heap;
+		if (heap > app->stats.heap_peak) app->stats.heap_peak = heap;
+	}
+	xTaskResumeAll();
+}
+
+// Number of app slots.
+size_t app_count() {
+	return APP_COUNT;
+}
+
+// Name of the app in slot `index`, or nullptr if out of range.
+const char *app_name(size_t index) {
+	return index < APP_COUNT ? apps[index].name : nullptr;
+}
+
+// Slot index of the app called `name`, or -1 if there is none.
+int app_find(const char *name) {
+	for (size_t i = 0; i < APP_COUNT; i++) {
+		if (!strcmp(apps[i].name, name)) return i;
+	}
+	return -1;
+}
+
+// Whether the app in slot `index` is running.
+bool app_running(size_t index) {
+	return index < APP_COUNT && apps[index].task;
+}
+
+// Get a copy of the resource usage of the app in slot `index`; kept after the app exits.
+// Returns false if `index` is out of range.
+bool app_get_stats(size_t index, app_stats *out) {
+	if (index >= APP_COUNT) return false;
+	app_update_stats(&apps[index]);
+	vTaskSuspendAll();
+	*out = apps[index].stats;
+	xTaskResumeAll();
+	return true;
+}
+
+// Periodically log a summary of per-app resource usage and the heap.
+static void telemetry_task(void *arg) {
+	uint32_t prev_cpu[APP_COUNT]    = {0};
+	uint32_t prev_starts[APP_COUNT] = {0};
+	int64_t  prev_time = esp_timer_get_time();
+	while (1) {
+		vTaskDelay(pdMS_TO_TICKS(TELEMETRY_INTERVAL_MS));
+		int64_t now     = esp_timer_get_time();
+		int64_t elapsed = now - prev_time;
+		prev_time       = now;
+		
+		for (size_t i = 0; i < APP_COUNT; i++) {
+			app_stats stats;
+			app_get_stats(i, &stats);
+			if (!stats.starts) continue;
+			if (stats.starts != prev_starts[i]) {
+				// The slot was (re)started and its CPU time counts from zero again.
+				prev_starts[i] = stats.starts;
+				prev_cpu[i]    = 0;
+			}
+			uint32_t permille = (uint64_t) (stats.cpu_us - prev_cpu[i]) * 1000 / elapsed;
+			prev_cpu[i] = stats.cpu_us;
+			ESP_LOGI(TAG, "%s%s: cpu %lu.%lu%%, heap %lu B (peak %lu B), stack min free %lu B, display_write %lu calls / %llu us",
+				apps[i].name, apps[i].task ? "" : " (exited)",
+				permille / 10, permille % 10,
+				stats.heap_used, stats.heap_peak,
+				stats.stack_free_min, stats.disp_calls, stats.disp_us
+			);
+		}
+		ESP_LOGI(TAG, "heap: free %u B, min free %u B",
+			heap_caps_get_free_size(MALLOC_CAP_DEFAULT),
+			heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT)
+		);
+	}
+}
+
+// Give display focus to `app`, or to nobody if `app` is nullptr.
+static void app_set_focus(embedded_app *app) {
+	xSemaphoreTake(disp_mutex, portMAX_DELAY);
+	focus_task = app ? app->task : nullptr;
+	xSemaphoreGive(disp_mutex);
+}
+
+// Give display focus to the app in slot `index`.
+// Returns false if `index` is out of range or the app is not running.
+bool app_focus(size_t index) {
+	if (index >= APP_COUNT) return false;
+	// Checked under the mutex so the app can't exit in between.
+	xSemaphoreTake(disp_mutex, portMAX_DELAY);
+	bool running = apps[index].task;
+	if (running) focus_task = apps[index].task;
+	xSemaphoreGive(disp_mutex);
+	return running;
+}
+
+// Task wrapper that loads and runs one embedded app.
+static void app_task(void *arg) {
+	embedded_app *app = (embedded_app *) arg;
+	
+	// Load the ELF thingylizer.
+	FILE *elf_fd = fmemopen((void*) app->elf_start, app->elf_end - app->elf_start, "r");
+	if (!elf_fd) {
+		ESP_LOGE(TAG, "Cannot open ELF of %s", app->name);
+	} else {
+		badgert_start_fd(app->name, elf_fd);
+		fclose(elf_fd);
+		ESP_LOGI(TAG, "App %s exited", app->name);
+	}
+	
+	// Pass focus on to the next app that is still running.
+	app_update_stats(app);
+	xSemaphoreTake(disp_mutex, portMAX_DELAY);
+	app->task = nullptr;
+	if (focus_task == xTaskGetCurrentTaskHandle()) {
+		focus_task = nullptr;
+		for (size_t i = 0; i < APP_COUNT && !focus_task; i++) {
+			focus_task = apps[i].task;
+		}
+	}
+	xSemaphoreGive(disp_mutex);
+	
+	vTaskDelete(nullptr);
+}
+
+// Create the task for `app` at idle priority so it doesn't run before focus is assigned.
+static bool app_create(embedded_app *app) {
+	vTaskSuspendAll();
+	uint32_t starts   = app->stats.starts;
+	app->stats        = {};
+	app->stats.starts = starts + 1;
+	xTaskResumeAll();
+	if (xTaskCreate(app_task, app->name, app->stack_size, app, tskIDLE_PRIORITY, &app->task) != pdPASS) {
+		ESP_LOGE(TAG, "Cannot create task for %s", app->name);
+		app->task = nullptr;
+		return false;
+	}
+	return true;
+}
+
+// Start an app received by the upload server and give it display focus.
+// Returns false if the previous uploaded app is still running.
+bool app_start_uploaded(const char *name, const void *elf, size_t elf_len) {
+	embedded_app *app = &apps[APP_UPLOAD_SLOT];
+	if (app->task) return false;
+	
+	app->name      = name;
+	app->elf_start = (const char *) elf;
+	app->elf_end   = (const char *) elf + elf_len;
+	if (!app_create(app)) return false;
+	app_set_focus(app);
+	vTaskPrioritySet(app->task, app->priority);
+	return true;
+}
+
 extern "C" void app_main() {
 	// mpu::appendRegion({
 	// 	0, 0x100000000,
@@ -56,6 +329,7 @@ extern "C" void app_main() {
 	}
 	driver_ssd1306_init();
 	driver_ssd1306_write(framebuffer);
+	disp_mutex = xSemaphoreCreateMutex();
 	
 	// Register display.
 	display_add(flush_my_disp, nullptr, 128, 64);
@@ -63,7 +337,25 @@ extern "C" void app_main() {
 	// Register LIBRARY.
 	badgert_register_buf("libpax.so", (void*) elflib_start, elflib_end-elflib_start);
 	
-	// Load the ELF thingylizer.
-	FILE *elf_fd = fmemopen((void*) elf_start, elf_end-elf_start, "r");
-	badgert_start_fd("main6.o", elf_fd);
+	// Create the embedded apps; the first one gets focus.
+	for (size_t i = 0; i < APP_COUNT; i++) {
+		if (apps[i].elf_start) app_create(&apps[i]);
+	}
+	for (size_t i = 0; i < APP_COUNT; i++) {
+		if (apps[i].task) {
+			app_set_focus(&apps[i]);
+			break;
+		}
+	}
+	
+	// Let the apps run.
+	for (size_t i = 0; i < APP_COUNT; i++) {
+		if (apps[i].task) vTaskPrioritySet(apps[i].task, apps[i].priority);
+	}
+	
+	// Start periodic resource usage logging.
+	xTaskCreate(telemetry_task, "telemetry", 3072, nullptr, 1, nullptr);
+	
+	// Accept new apps and libraries over the console UART.
+	upload_start();
 }
@@ -0,0 +1,282 @@
+
+#include "upload.hpp"
+#include "apps.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <esp_log.h>
+static const char *TAG = "upload";
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <driver/uart.h>
+#include <esp_rom_crc.h>
+
+#include <badgert.h>
+
+/*
+Framed upload protocol, all integers little-endian:
+	u8  magic[2]   'U' 'P'
+	u8  type       UPLOAD_T_*
+	u16 length     payload length, at most UPLOAD_MAX_PAYLOAD
+	u8  payload[length]
+	u32 crc32      CRC32 of type, length and payload
+
+HELLO   u32 baudrate, u32 image size, u8 kind (UPLOAD_KIND_*), char name[]
+DATA    u32 offset, u8 data[]
+DONE    u32 CRC32 of the entire image
+ABORT   (empty)
+ACK/NAK u8 type of the frame being answered
+
+Every frame is answered with an ACK or NAK. After acknowledging a HELLO,
+both sides switch to the requested baudrate; after DONE or a timeout the
+device returns to the console baudrate. ESP_LOG output is dropped while a
+session is open so it cannot get in between the frames. If no valid frame arrives at the
+new baudrate within UPLOAD_SWITCH_MS, e.g. because the HELLO ACK was lost
+and the host is still retrying at the old one, the device drops the
+session and falls back to the console baudrate.
+*/
+
+// UART shared with the console.
+#define UPLOAD_UART			UART_NUM_0
+// Baudrate used outside of an upload session.
+#define UPLOAD_IDLE_BAUD	CONFIG_ESP_CONSOLE_UART_BAUDRATE
+// Fastest baudrate a host may request.
+#define UPLOAD_MAX_BAUD		5000000
+// Maximum payload size of a single frame.
+#define UPLOAD_MAX_PAYLOAD	4096
+// Largest image that will be accepted.
+#define UPLOAD_MAX_IMAGE	(192*1024)
+// Time without a frame after which a session is aborted.
+#define UPLOAD_TIMEOUT_MS	2000
+// Time to wait for the first valid frame after switching baudrate.
+#define UPLOAD_SWITCH_MS	500
+// Maximum length of an uploaded app or library name.
+#define UPLOAD_MAX_NAME		31
+
+// Frame types.
+#define UPLOAD_T_HELLO	0x01
+#define UPLOAD_T_DATA	0x02
+#define UPLOAD_T_DONE	0x03
+#define UPLOAD_T_ABORT	0x04
+#define UPLOAD_T_ACK	0x80
+#define UPLOAD_T_NAK	0x81
+
+// Image kinds in a HELLO frame.
+#define UPLOAD_KIND_APP	0
+#define UPLOAD_KIND_LIB	1
+
+// State of the current upload session.
+typedef struct {
+	// Image buffer, nullptr when no session is active.
+	uint8_t *buf;
+	// Size of the image being received.
+	size_t   size;
+	// Kind of image being received.
+	uint8_t  kind;
+	// Whether a valid frame has been received since the baudrate switch.
+	bool     confirmed;
+	// Name to register the image under.
+	char     name[UPLOAD_MAX_NAME+1];
+} upload_session_t;
+
+static upload_session_t session;
+// Image of the last uploaded app, freed once a new app replaces it.
+static uint8_t *app_image;
+// Frame receive buffer.
+static uint8_t  frame[5 + UPLOAD_MAX_PAYLOAD + 4];
+
+static inline uint32_t read_u32(const uint8_t *ptr) {
+	return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t) ptr[3] << 24);
+}
+
+static inline void write_u32(uint8_t *ptr, uint32_t val) {
+	ptr[0] = val;
+	ptr[1] = val >> 8;
+	ptr[2] = val >> 16;
+	ptr[3] = val >> 24;
+}
+
+// Send an ACK or NAK frame for a frame of type `type`.
+static void upload_reply(bool ack, uint8_t type) {
+	uint8_t out[10] = { 'U', 'P', (uint8_t) (ack ? UPLOAD_T_ACK : UPLOAD_T_NAK), 1, 0, type };
+	write_u32(out + 6, esp_rom_crc32_le(0, out + 2, 4));
+	uart_write_bytes(UPLOAD_UART, out, sizeof(out));
+}
+
+// Log output function that drops everything, installed while a session is open.
+static int upload_mute_log(const char *fmt, va_list args) {
+	return 0;
+}
+
+// Drop ESP_LOG output from every task while a session is open.
+static void upload_mute(bool mute) {
+	static vprintf_like_t saved_vprintf;
+	if (mute && !saved_vprintf) {
+		uart_wait_tx_done(UPLOAD_UART, pdMS_TO_TICKS(100));
+		saved_vprintf = esp_log_set_vprintf(upload_mute_log);
+	} else if (!mute && saved_vprintf) {
+		esp_log_set_vprintf(saved_vprintf);
+		saved_vprintf = nullptr;
+	}
+}
+
+// Drop the current session and return to the console baudrate.
+static void upload_reset() {
+	free(session.buf);
+	session.buf = nullptr;
+	uart_wait_tx_done(UPLOAD_UART, pdMS_TO_TICKS(100));
+	uart_set_baudrate(UPLOAD_UART, UPLOAD_IDLE_BAUD);
+	upload_mute(false);
+}
+
+// Receive one frame into `frame`.
+// Returns the payload length, -1 on timeout or -2 on a corrupt frame.
+static int upload_recv(TickType_t timeout) {
+	// Hunt for the magic bytes; anything else on the line is ignored, but only until `timeout`
+	// so that a steady stream of noise cannot hold off the timeout forever.
+	TickType_t start = xTaskGetTickCount();
+	uint8_t    prev  = 0, cur = 0;
+	while (prev != 'U' || cur != 'P') {
+		TickType_t left = timeout;
+		if (timeout != portMAX_DELAY) {
+			TickType_t spent = xTaskGetTickCount() - start;
+			if (spent >= timeout) return -1;
+			left = timeout - spent;
+		}
+		prev = cur;
+		if (uart_read_bytes(UPLOAD_UART, &cur, 1, left) != 1) return -1;
+	}
+	
+	// Header.
+	if (uart_read_bytes(UPLOAD_UART, frame, 3, pdMS_TO_TICKS(UPLOAD_TIMEOUT_MS)) != 3) return -1;
+	int len = frame[1] | (frame[2] << 8);
+	if (len > UPLOAD_MAX_PAYLOAD) return -2;
+	
+	// Payload and checksum.
+	if (uart_read_bytes(UPLOAD_UART, frame + 3, len + 4, pdMS_TO_TICKS(UPLOAD_TIMEOUT_MS)) != len + 4) return -1;
+	if (read_u32(frame + 3 + len) != esp_rom_crc32_le(0, frame, 3 + len)) return -2;
+	return len;
+}
+
+// Handle a HELLO frame; starts a new session.
+static bool upload_hello(const uint8_t *payload, int len) {
+	if (len < 10 || len > 9 + UPLOAD_MAX_NAME) return false;
+	uint32_t baud = read_u32(payload);
+	uint32_t size = read_u32(payload + 4);
+	uint8_t  kind = payload[8];
+	if (baud > UPLOAD_MAX_BAUD || size == 0 || size > UPLOAD_MAX_IMAGE) return false;
+	if (kind != UPLOAD_KIND_APP && kind != UPLOAD_KIND_LIB) return false;
+	
+	free(session.buf);
+	session.buf = (uint8_t *) malloc(size);
+	if (!session.buf) return false;
+	session.size = size;
+	session.kind = kind;
+	memcpy(session.name, payload + 9, len - 9);
+	session.name[len - 9] = 0;
+	upload_mute(true);
+	
+	// Switch baudrate only after the ACK has been sent at the old one.
+	upload_reply(true, UPLOAD_T_HELLO);
+	uart_wait_tx_done(UPLOAD_UART, pdMS_TO_TICKS(100));
+	// Without a baudrate change there is nothing to confirm.
+	session.confirmed = !baud;
+	if (baud) uart_set_baudrate(UPLOAD_UART, baud);
+	return true;
+}
+
+// Handle a DONE frame; verifies and hands over the image.
+static bool upload_done(const uint8_t *payload, int len) {
+	if (len != 4 || read_u32(payload) != esp_rom_crc32_le(0, session.buf, session.size)) return false;
+	
+	if (session.kind == UPLOAD_KIND_LIB) {
+		// Registered libraries are never unregistered, so the buffer is kept forever.
+		char *name = strdup(session.name);
+		if (!name) return false;
+		badgert_register_buf(name, session.buf, session.size);
+	} else {
+		static char app_name[UPLOAD_MAX_NAME+1];
+		strcpy(app_name, session.name);
+		if (!app_start_uploaded(app_name, session.buf, session.size)) return false;
+		free(app_image);
+		app_image = session.buf;
+	}
+	session.buf = nullptr;
+	return true;
+}
+
+// Receives frames and dispatches them.
+static void upload_task(void *arg) {
+	while (1) {
+		TickType_t timeout = portMAX_DELAY;
+		if (session.buf) {
+			timeout = pdMS_TO_TICKS(session.confirmed ? UPLOAD_TIMEOUT_MS : UPLOAD_SWITCH_MS);
+		}
+		int len = upload_recv(timeout);
+		if (len == -2 && session.buf && !session.confirmed) {
+			// Likely the host still talking at the old baudrate; go back to it.
+			upload_reset();
+			ESP_LOGW(TAG, "No valid frame after baudrate switch");
+			continue;
+		} else if (len == -2) {
+			// Corrupt frames are not answered; the host retries after its own timeout.
+			continue;
+		} else if (len < 0) {
+			if (session.buf) {
+				upload_reset();
+				ESP_LOGW(TAG, "Upload timed out");
+			}
+			continue;
+		}
+		
+		uint8_t        type    = frame[0];
+		const uint8_t *payload = frame + 3;
+		bool           ok      = false;
+		session.confirmed = true;
+		
+		if (type == UPLOAD_T_HELLO) {
+			if (upload_hello(payload, len)) continue;
+		} else if (type == UPLOAD_T_DATA && session.buf && len >= 4) {
+			uint32_t offset = read_u32(payload);
+			if (offset <= session.size && len - 4 <= session.size - offset) {
+				memcpy(session.buf + offset, payload + 4, len - 4);
+				ok = true;
+			}
+		} else if (type == UPLOAD_T_DONE && session.buf) {
+			ok = upload_done(payload, len);
+			upload_reply(ok, type);
+			upload_reset();
+			// Logging is only back on once the session is closed.
+			if (!ok) {
+				ESP_LOGE(TAG, "Upload of %s failed; bad checksum or previous app still running", session.name);
+			} else if (session.kind == UPLOAD_KIND_LIB) {
+				ESP_LOGI(TAG, "Registered library %s (%u bytes)", session.name, session.size);
+			} else {
+				ESP_LOGI(TAG, "Started app %s (%u bytes)", session.name, session.size);
+			}
+			continue;
+		} else if (type == UPLOAD_T_ABORT) {
+			ok = true;
+			upload_reply(ok, type);
+			upload_reset();
+			continue;
+		}
+		upload_reply(ok, type);
+	}
+}
+
+// Start the upload server on the console UART.
+void upload_start() {
+	esp_err_t res = uart_driver_install(UPLOAD_UART, 2 * UPLOAD_MAX_PAYLOAD, 0, 0, nullptr, 0);
+	if (res) {
+		ESP_LOGE(TAG, "UART driver install failed: %s", esp_err_to_name(res));
+		return;
+	}
+	// Interrupt on a nearly full FIFO so high baudrates don't overrun it.
+	uart_set_rx_full_threshold(UPLOAD_UART, 96);
+	uart_set_rx_timeout(UPLOAD_UART, 2);
+	xTaskCreate(upload_task, "upload", 3072, nullptr, 5, nullptr);
+}
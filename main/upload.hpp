@@ -0,0 +1,8 @@
+
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Start the upload server on the console UART.
+void upload_start();
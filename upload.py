@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+
+# Sends an app or library to the firmware's upload server over the console UART.
+# See main/upload.cpp for a description of the frame format.
+
+import argparse, os, struct, sys, time, zlib
+import serial
+
+T_HELLO = 0x01
+T_DATA  = 0x02
+T_DONE  = 0x03
+T_ABORT = 0x04
+T_ACK   = 0x80
+T_NAK   = 0x81
+
+MAX_PAYLOAD = 4096
+
+def make_frame(ftype, payload):
+    body = struct.pack("<BH", ftype, len(payload)) + payload
+    return b"UP" + body + struct.pack("<I", zlib.crc32(body))
+
+def read_reply(port, timeout):
+    # Skip console output until a valid reply frame shows up.
+    deadline = time.monotonic() + timeout
+    window   = b""
+    while time.monotonic() < deadline:
+        window = (window + port.read(1))[-2:]
+        if window != b"UP":
+            continue
+        hdr = port.read(3)
+        if len(hdr) != 3:
+            continue
+        ftype, length = struct.unpack("<BH", hdr)
+        rest = port.read(length + 4)
+        if len(rest) != length + 4:
+            continue
+        if struct.unpack("<I", rest[length:])[0] != zlib.crc32(hdr + rest[:length]):
+            continue
+        return ftype
+    return None
+
+def transact(port, ftype, payload, retries=3, timeout=1.0):
+    for _ in range(retries):
+        port.write(make_frame(ftype, payload))
+        reply = read_reply(port, timeout)
+        if reply == T_ACK:
+            return
+        if reply == T_NAK and ftype != T_DATA:
+            break
+    raise RuntimeError("frame type 0x%02x not acknowledged" % ftype)
+
+def start_session(port, args, image, name):
+    # Switch to the upload baudrate and confirm it with the first DATA frame.
+    # If that goes unanswered the device falls back to the console baudrate
+    # on its own, so start over there without switching.
+    hello = struct.pack("<IIB", args.upload_baud, len(image), 1 if args.lib else 0) + name
+    transact(port, T_HELLO, hello)
+    port.baudrate = args.upload_baud
+    first = struct.pack("<I", 0) + image[:MAX_PAYLOAD-4]
+    try:
+        transact(port, T_DATA, first, retries=1)
+        return
+    except RuntimeError:
+        print("No reply at %d baud, staying at %d" % (args.upload_baud, args.baud), file=sys.stderr)
+    port.baudrate = args.baud
+    time.sleep(0.5)
+    port.reset_input_buffer()
+    transact(port, T_HELLO, struct.pack("<I", 0) + hello[4:])
+    transact(port, T_DATA, first)
+
+def main():
+    parser = argparse.ArgumentParser(description="Upload an app or library to the ESP32-C6")
+    parser.add_argument("file", help="ELF file to upload")
+    parser.add_argument("-p", "--port", default="/dev/ttyUSB0")
+    parser.add_argument("-b", "--baud", type=int, default=115200, help="console baudrate")
+    parser.add_argument("-B", "--upload-baud", type=int, default=2000000, help="baudrate during the upload")
+    parser.add_argument("-l", "--lib", action="store_true", help="register as a library instead of starting an app")
+    parser.add_argument("-n", "--name", help="name to register as (default: file name)")
+    args = parser.parse_args()
+    
+    image = open(args.file, "rb").read()
+    name  = (args.name or os.path.basename(args.file)).encode()
+    
+    port = serial.Serial(args.port, args.baud, timeout=0.1)
+    start = time.monotonic()
+    try:
+        start_session(port, args, image, name)
+        
+        chunk = MAX_PAYLOAD - 4
+        for offset in range(chunk, len(image), chunk):
+            transact(port, T_DATA, struct.pack("<I", offset) + image[offset:offset+chunk])
+        transact(port, T_DONE, struct.pack("<I", zlib.crc32(image)))
+    except Exception as e:
+        port.write(make_frame(T_ABORT, b""))
+        print("Upload failed: %s" % e, file=sys.stderr)
+        sys.exit(1)
+    finally:
+        port.baudrate = args.baud
+    print("Uploaded %s (%d bytes) in %.2f s" % (name.decode(), len(image), time.monotonic() - start))
+
+if __name__ == "__main__":
+    main()